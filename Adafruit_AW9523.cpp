@@ -33,11 +33,17 @@
 #include "Arduino.h"
 
 #include "Adafruit_AW9523.h"
+#include "Adafruit_AW9523_SoftI2C.h"
+#include "Adafruit_AW9523_Trace.h"
 
 /*!
  *    @brief  Instantiates a new AW9523 class
  */
-Adafruit_AW9523::Adafruit_AW9523(void) {}
+Adafruit_AW9523::Adafruit_AW9523(void) {
+#ifdef AW9523_LATENCY_STATS
+  clearLatencyStats();
+#endif
+}
 
 Adafruit_AW9523::~Adafruit_AW9523(void) {}
 
@@ -49,22 +55,47 @@ Adafruit_AW9523::~Adafruit_AW9523(void) {}
  *    @return True if initialization was successful, otherwise false.
  */
 bool Adafruit_AW9523::begin(uint8_t addr, TwoWire *wire) {
+  if (!attach(addr, wire, true)) {
+    return false;
+  }
+  return init();
+}
+
+/*!
+ *    @brief  Sets up the hardware on a bit-banged bus, for boards with no
+ *            free I2C peripheral. The bus must have had its own begin().
+ *            A group's begin() keeps a chip on the bus given here, so
+ *            begin() a chip with this once before adding it to a group
+ *    @param  addr The I2C address for the expander
+ *    @param  soft The bus the expander is on
+ *    @return True if initialization was successful, otherwise false.
+ */
+bool Adafruit_AW9523::begin(uint8_t addr, Adafruit_AW9523_SoftI2C *soft) {
   if (i2c_dev) {
     delete i2c_dev; // remove old interface
+    i2c_dev = NULL;
   }
+  _wire = NULL;
+  _soft = soft;
+  _address = addr;
 
-  i2c_dev = new Adafruit_I2CDevice(addr, wire);
-
-  if (!i2c_dev->begin()) {
+  if (!soft->write(addr, NULL, 0)) {
     return false;
   }
+  return init();
+}
 
+/*!
+ *    @brief  Resets and configures the chip once the bus is set up
+ *    @return True if initialization was successful, otherwise false.
+ */
+bool Adafruit_AW9523::init(void) {
   if (!reset()) {
     return false;
   }
 
-  Adafruit_I2CRegister idreg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_CHIPID);
-  if (idreg.read() != 0x23) {
+  uint8_t id;
+  if (!readField<AW9523_CHIPID>(&id) || (id != 0x23)) {
     return false;
   }
 
@@ -75,14 +106,39 @@ bool Adafruit_AW9523::begin(uint8_t addr, TwoWire *wire) {
   return true;
 }
 
+/*!
+ *    @brief  Makes the I2C interface for the chip, without touching it
+ *    @param  addr The I2C address for the expander
+ *    @param  wire The Wire object to be used for I2C connections
+ *    @param  detect True to check the chip answers at the address
+ *    @return True if the chip answered, or detect was false
+ */
+bool Adafruit_AW9523::attach(uint8_t addr, TwoWire *wire, bool detect) {
+  if (i2c_dev) {
+    delete i2c_dev; // remove old interface
+  }
+
+  i2c_dev = new Adafruit_I2CDevice(addr, wire);
+  _wire = wire;
+  _soft = NULL;
+  _address = addr;
+  return i2c_dev->begin(detect);
+}
+
 /*!
  *    @brief  Perform a soft reset over I2C
  *    @return True I2C reset command was acknowledged
  */
 bool Adafruit_AW9523::reset(void) {
-  Adafruit_I2CRegister resetreg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_SOFTRESET);
+  AW9523_TRACE_SPAN("reset", NULL);
+  uint8_t zero = 0;
 
-  return resetreg.write(0);
+  if (!writeRegisters(AW9523_REG_SOFTRESET, &zero, 1)) {
+    return false;
+  }
+  _intEnabled = 0xFFFF; // INTENABLE resets to all enabled
+  // output defaults depend on the AD pins, so pick them up from the chip
+  return readRegister16<AW9523_OUTPUT>(&_outputs);
 }
 
 /*!
@@ -91,25 +147,57 @@ bool Adafruit_AW9523::reset(void) {
  *    @return True I2C write command was acknowledged
  */
 bool Adafruit_AW9523::outputGPIO(uint16_t pins) {
-  Adafruit_I2CRegister output0reg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_OUTPUT0, 2, LSBFIRST);
-  Adafruit_I2CRegister output1reg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_OUTPUT1, 2, LSBFIRST);
+  return writeRegister16<AW9523_OUTPUT>(pins);
+}
 
-  if (!output0reg.write(pins) || !output1reg.write(pins)) {
-    return false;
+/*!
+ *    @brief  Sets output value (1 == high) for some GPIO, leaving the others
+ *            as last written. Works from the driver's copy of the outputs so
+ *            there is no read, and only writes the ports that change
+ *    @param  pins 16-bits of binary output settings
+ *    @param  mask 16-bits of pins to change, 1 == change
+ *    @return True I2C write command was acknowledged
+ */
+bool Adafruit_AW9523::outputGPIOMasked(uint16_t pins, uint16_t mask) {
+  uint16_t value = (_outputs & ~mask) | (pins & mask);
+  uint16_t changed = value ^ _outputs;
+  uint8_t buffer[2] = {(uint8_t)value, (uint8_t)(value >> 8)};
+
+  if (!(changed & 0xFF00)) {
+    return (changed == 0) || writeRegisters(AW9523_REG_OUTPUT0, buffer, 1);
   }
-  return true;
+  if (!(changed & 0x00FF)) {
+    return writeRegisters(AW9523_REG_OUTPUT1, buffer + 1, 1);
+  }
+  return writeRegisters(AW9523_REG_OUTPUT0, buffer, 2);
 }
 
+/*!
+ *    @brief  Sets output value (1 == high) for the 8 GPIO of one port, in a
+ *            single byte write
+ *    @param  port 0 for GPIO 0-7, 1 for GPIO 8-15
+ *    @param  pins 8-bits of binary output settings
+ *    @return True I2C write command was acknowledged
+ */
+bool Adafruit_AW9523::outputPort(uint8_t port, uint8_t pins) {
+  return writeRegisters(AW9523_REG_OUTPUT0 + (port & 1), &pins, 1);
+}
+
+/*!
+ *    @brief  Gets the output values last written, without any bus traffic
+ *    @return 16-bits of binary output settings
+ */
+uint16_t Adafruit_AW9523::outputs(void) { return _outputs; }
+
 /*!
  *    @brief  Reads input value (1 == high) for all 16 GPIO
  *    @return 16-bits of binary input (0 == low & 1 == high)
  */
 uint16_t Adafruit_AW9523::inputGPIO(void) {
-  Adafruit_I2CRegister input0reg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_INPUT0, 2, LSBFIRST);
-  Adafruit_I2CRegister input1reg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_INPUT1, 2, LSBFIRST);
+  uint16_t pins = 0;
 
-  uint16_t out = (input1reg.read() << 8) | input0reg.read();
-  return out;
+  readRegister16<AW9523_INPUT>(&pins);
+  return pins;
 }
 
 /*!
@@ -118,12 +206,10 @@ uint16_t Adafruit_AW9523::inputGPIO(void) {
  *    @return True I2C write command was acknowledged
  */
 bool Adafruit_AW9523::interruptEnableGPIO(uint16_t pins) {
-  Adafruit_I2CRegister int0reg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_INTENABLE0, 2, LSBFIRST);
-  Adafruit_I2CRegister int1reg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_INTENABLE1, 2, LSBFIRST);
-
-  if (!int0reg.write(~pins) || !int1reg.write(~(pins >> 8))) {
+  if (!writeRegister16<AW9523_INTENABLE>(~pins)) {
     return false;
   }
+  _intEnabled = pins;
   return true;
 }
 
@@ -133,14 +219,7 @@ bool Adafruit_AW9523::interruptEnableGPIO(uint16_t pins) {
  *    @return True I2C write command was acknowledged
  */
 bool Adafruit_AW9523::configureDirection(uint16_t pins) {
-  Adafruit_I2CRegister conf0reg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_CONFIG0, 2, LSBFIRST);
-  Adafruit_I2CRegister conf1reg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_CONFIG1, 2, LSBFIRST);
-
-  if (!conf0reg.write(~pins) || !conf1reg.write(~(pins >> 8))) {
-    return false;
-  }
-
-  return true;
+  return writeRegister16<AW9523_CONFIG>(~pins);
 }
 
 /*!
@@ -149,52 +228,45 @@ bool Adafruit_AW9523::configureDirection(uint16_t pins) {
  *    @return True I2C write command was acknowledged
  */
 bool Adafruit_AW9523::configureLEDMode(uint16_t pins) {
-  Adafruit_I2CRegister ledmode0reg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_LEDMODE0, 2, LSBFIRST);
-  Adafruit_I2CRegister ledmode1reg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_LEDMODE1, 2, LSBFIRST);
-
-  if (!ledmode0reg.write(~pins) || !ledmode1reg.write(~(pins >> 8))) {
-    return false;
-  }
-
-  return true;
+  return writeRegister16<AW9523_LEDMODE>(~pins);
 }
 
 /*!
  *    @brief  Sets constant-current setting for one pin
  *    @param  pin GPIO to set, from 0 to 15 inclusive
  *    @param  val Ratio to set, from 0 (off) to 255 (max current)
+ *    @return True I2C write command was acknowledged
  */
-void Adafruit_AW9523::analogWrite(uint8_t pin, uint8_t val) {
-  uint8_t reg;
-
-  // See Table 13. 256 step dimming control register
-  if ((pin >= 0) && (pin <= 7)) {
-    reg = 0x24 + pin;
-  }
-  if ((pin >= 8) && (pin <= 11)) {
-    reg = 0x20 + pin - 8;
-  }
-  if ((pin >= 12) && (pin <= 15)) {
-    reg = 0x2C + pin - 12;
-  }
+bool Adafruit_AW9523::analogWrite(uint8_t pin, uint8_t val) {
+  return writeRegisters(AW9523_dimRegister(pin), &val, 1);
+}
 
-  Adafruit_I2CRegister ledCCreg = Adafruit_I2CRegister(i2c_dev, reg);
+/*!
+ *    @brief  Sets constant-current setting for all 16 GPIO in one burst
+ *    @param  vals 16 ratios indexed by pin, from 0 (off) to 255 (max current)
+ *    @return True I2C write command was acknowledged
+ */
+bool Adafruit_AW9523::analogWriteGPIO(const uint8_t *vals) {
+  uint8_t buffer[16];
 
-  ledCCreg.write(val);
+  // dimming registers run P1_0-3, P0_0-7, P1_4-7 from 0x20
+  for (uint8_t pin = 0; pin < 16; pin++) {
+    buffer[AW9523_dimRegister(pin) - 0x20] = vals[pin];
+  }
+  return writeRegisters(0x20, buffer, 16);
 }
 
 /*!
  *    @brief  Sets digital output for one pin
  *    @param  pin GPIO to set, from 0 to 15 inclusive
  *    @param  val True for high value, False for low value
+ *    @return True I2C read and write commands were acknowledged
  */
-void Adafruit_AW9523::digitalWrite(uint8_t pin, bool val) {
-  Adafruit_I2CRegister output0reg =
-      Adafruit_I2CRegister(i2c_dev, AW9523_REG_OUTPUT0, 2, LSBFIRST);
-  Adafruit_I2CRegisterBits outbit =
-      Adafruit_I2CRegisterBits(&output0reg, 1, pin); // # bits, bit_shift
+bool Adafruit_AW9523::digitalWrite(uint8_t pin, bool val) {
+  uint8_t bit = 1 << (pin & 7);
 
-  outbit.write(val);
+  return updateRegister(AW9523_REG_OUTPUT0 + (pin >> 3), bit,
+                        val ? bit : 0);
 }
 
 /*!
@@ -203,33 +275,32 @@ void Adafruit_AW9523::digitalWrite(uint8_t pin, bool val) {
  *    @returns True for high value read, False for low value read
  */
 bool Adafruit_AW9523::digitalRead(uint8_t pin) {
+  uint8_t value = 0;
 
-  Adafruit_I2CRegister inputreg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_INPUT0, 2, LSBFIRST);
-  uint8_t outPin = pin;
-
-  if (pin >= 8) {
-    inputreg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_INPUT1, 2, LSBFIRST);
-    outPin = pin - 8;
-  }
-
-  Adafruit_I2CRegisterBits inbit = Adafruit_I2CRegisterBits(&inputreg, 1, outPin); // # bits, bit_shift
-  return inbit.read();
+  readRegisters(AW9523_REG_INPUT0 + (pin >> 3), &value, 1);
+  return (value >> (pin & 7)) & 0x1;
 }
 
 /*!
  *    @brief  Sets interrupt enable for one pin
  *    @param  pin GPIO to set, from 0 to 15 inclusive
  *    @param  en True to enable Interrupt detect, False for ignore
+ *    @return True I2C read and write commands were acknowledged
  */
-void Adafruit_AW9523::enableInterrupt(uint8_t pin, bool en) {
-  Adafruit_I2CRegister intenablereg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_INTENABLE0, 2, LSBFIRST);
+bool Adafruit_AW9523::enableInterrupt(uint8_t pin, bool en) {
+  uint8_t bit = 1 << (pin & 7);
 
-  if (pin >= 8) {
-    intenablereg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_INTENABLE1, 2, LSBFIRST);
+  // register bits are 'interrupt disable'
+  if (!updateRegister(AW9523_REG_INTENABLE0 + (pin >> 3), bit,
+                      en ? 0 : bit)) {
+    return false;
   }
-      
-  Adafruit_I2CRegisterBits irqbit = Adafruit_I2CRegisterBits(&intenablereg, 1, pin); // # bits, bit_shift
-  irqbit.write(!en);
+  if (en) {
+    _intEnabled |= 1U << pin;
+  } else {
+    _intEnabled &= ~(1U << pin);
+  }
+  return true;
 }
 
 /*!
@@ -237,49 +308,766 @@ void Adafruit_AW9523::enableInterrupt(uint8_t pin, bool en) {
  *    @param  pin GPIO to set, from 0 to 15 inclusive
  *    @param  mode Can be INPUT, OUTPUT for GPIO digital, or AW9523_LED_MODE for
  * constant current LED drive
+ *    @return True I2C read and write commands were acknowledged, false
+ *            without touching the chip for any other mode
  */
-void Adafruit_AW9523::pinMode(uint8_t pin, uint8_t mode) {
-  // GPIO Direction
-  Adafruit_I2CRegister confreg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_CONFIG0, 2, LSBFIRST);
-  // GPIO mode or LED mode?
-  Adafruit_I2CRegister ledmodereg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_LEDMODE0, 2, LSBFIRST);
-  uint8_t outPin = pin;
+bool Adafruit_AW9523::pinMode(uint8_t pin, uint8_t mode) {
+  uint8_t bit = 1 << (pin & 7);
+  uint8_t port = pin >> 3;
 
-  if (pin >= 8) {
-    confreg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_CONFIG1, 2, LSBFIRST);
-    ledmodereg = Adafruit_I2CRegister(i2c_dev, AW9523_REG_LEDMODE1, 2, LSBFIRST);
-    outPin = pin - 8;
-  }
-      
-  Adafruit_I2CRegisterBits confbit = Adafruit_I2CRegisterBits(&confreg, 1, outPin); // # bits, bit_shift
-  Adafruit_I2CRegisterBits modebit = Adafruit_I2CRegisterBits(&ledmodereg, 1, outPin); // # bits, bit_shift
-
-  if (mode == OUTPUT) {
-    confbit.write(0);
-    modebit.write(1);
-  }
-  if (mode == INPUT) {
-    confbit.write(1);
-    modebit.write(1);
+  if ((mode != INPUT) && (mode != OUTPUT) && (mode != AW9523_LED_MODE)) {
+    return false; // e.g. INPUT_PULLUP, which the chip has no pull-ups for
   }
 
-  if (mode == AW9523_LED_MODE) {
-    confbit.write(0);
-    modebit.write(0);
+  // GPIO Direction, 1 == input
+  if (!updateRegister(AW9523_REG_CONFIG0 + port, bit,
+                      (mode == INPUT) ? bit : 0)) {
+    return false;
   }
+  // GPIO mode or LED mode? 1 == GPIO
+  return updateRegister(AW9523_REG_LEDMODE0 + port, bit,
+                        (mode == AW9523_LED_MODE) ? 0 : bit);
 }
 
+/*!
+ *    @brief  Checks whether any transfer has failed since the last
+ *            clearBusError(), so a run of writes can be checked once at the
+ *            end instead of reading the registers back
+ *    @return True if a transfer was not acknowledged
+ */
+bool Adafruit_AW9523::busError(void) { return _busError; }
+
+/*!
+ *    @brief  Clears the sticky error reported by busError()
+ */
+void Adafruit_AW9523::clearBusError(void) { _busError = false; }
+
 /*!
  *    @brief  Turns on/off open drain output for ALL port 0 pins (GPIO 0-7)
  *    @param  od True to enable open drain, False for push-pull
  *    @return True I2C write command was acknowledged
  */
 bool Adafruit_AW9523::openDrainPort0(bool od) {
-  Adafruit_I2CRegister gcrreg =
-      Adafruit_I2CRegister(i2c_dev, AW9523_REG_GCR, 1);
+  return writeField<AW9523_GCR_GPOMD>(!od);
+}
 
-  Adafruit_I2CRegisterBits opendrain =
-      Adafruit_I2CRegisterBits(&gcrreg, 1, 4); // # bits, bit_shift
+/*!
+ *    @brief  Notes that the INT line fired. Call this from the host pin
+ *            interrupt attached to the AW9523 INT output, then call
+ *            service() from loop()
+ */
+void Adafruit_AW9523::interruptTriggered(void) {
+  _intMicros = micros();
+  _intCount++;
+  _intPending = true;
+}
 
-  return opendrain.write(!od);
+/*!
+ *    @brief  Sets the function that service() calls when inputs change
+ *    @param  callback Function to call, or NULL for none
+ *    @param  pins 16-bits of pins the callback is for, changes on other
+ *            pins do not call it
+ */
+void Adafruit_AW9523::onChange(aw9523_callback_t callback, uint16_t pins) {
+  _callback = callback;
+  _callbackPins = pins;
+}
+
+/*!
+ *    @brief  Handles a pending interrupt: reads all inputs (which also
+ *            clears the interrupt on the chip) and runs the change callback
+ *    @return True if an interrupt was pending and has been handled
+ */
+bool Adafruit_AW9523::service(void) {
+  if (!_intPending) {
+    return false;
+  }
+  serviceInputs(true);
+  return true;
+}
+
+/*!
+ *    @brief  Declares input pins the sketch cares about beyond those with
+ *            interrupts enabled or given to onChange(). Input servicing
+ *            reads only the ports these are on
+ *    @param  pins 16-bits of pins of interest, 0 for none
+ */
+void Adafruit_AW9523::setInterest(uint16_t pins) { _interest = pins; }
+
+/*!
+ *    @brief  Gets the input pins service() and polling read: those declared
+ *            with setInterest(), those with interrupts enabled and those
+ *            the onChange() callback is for. If nothing is declared, all
+ *    @return 16-bits of pins of interest
+ */
+uint16_t Adafruit_AW9523::interest(void) {
+  uint16_t pins = _interest | _intEnabled | (_callback ? _callbackPins : 0);
+  return pins ? pins : 0xFFFF;
+}
+
+/*!
+ *    @brief  Estimated bus time of one input service with the current
+ *            interest: a one byte read if only one port is of interest,
+ *            two bytes otherwise
+ *    @return Microseconds, going by estimateMicros()
+ */
+uint32_t Adafruit_AW9523::serviceMicros(void) {
+  uint16_t pins = interest();
+  return estimateMicros(1, ((pins & 0xFF) && (pins >> 8)) ? 2 : 1);
+}
+
+/*!
+ *    @brief  Reads the inputs of interest and runs the change callback.
+ *            When only one port is of interest just that port is read,
+ *            which also clears an interrupt raised by that port
+ *    @param  interrupt True when servicing an INT edge, false for a poll
+ */
+void Adafruit_AW9523::serviceInputs(bool interrupt) {
+  AW9523_TRACE_SPAN(interrupt ? "service" : "poll", NULL);
+#ifdef AW9523_LATENCY_STATS
+  // both times in one critical section, or an edge landing between them
+  // would be later than entered and the difference would wrap
+  noInterrupts();
+  uint32_t edge = _intMicros;
+  uint32_t entered = micros();
+  _intPending = false;
+  interrupts();
+#else
+  _intPending = false;
+#endif
+
+  uint16_t pins = interest();
+  uint16_t inputs = _lastInputs;
+  if ((pins & 0xFF) && (pins >> 8)) {
+    inputs = inputGPIO();
+  } else {
+    uint8_t port = (pins & 0xFF) ? 0 : 1;
+    uint8_t value;
+    if (readRegisters(AW9523_REG_INPUT0 + port, &value, 1)) {
+      inputs = port ? ((inputs & 0x00FF) | ((uint16_t)value << 8))
+                    : ((inputs & 0xFF00) | value);
+    }
+  }
+#ifdef AW9523_LATENCY_STATS
+  uint32_t read = micros();
+#endif
+  uint16_t changed = inputs ^ _lastInputs;
+  _lastInputs = inputs;
+
+  changed &= _callbackPins;
+  if (changed && _callback) {
+    _callback(changed, inputs);
+  }
+
+#ifdef AW9523_LATENCY_STATS
+  if (interrupt) {
+    recordLatency(AW9523_LATENCY_EDGE_TO_SERVICE, entered - edge);
+    recordLatency(AW9523_LATENCY_SERVICE_TO_READ, read - entered);
+    recordLatency(AW9523_LATENCY_READ_TO_CALLBACK, micros() - read);
+    _latency.samples++;
+  }
+#else
+  (void)interrupt;
+#endif
+}
+
+/*!
+ *    @brief  Does as much pending background work as fits in a time budget:
+ *            interrupt servicing, input polling, health checks and any added
+ *            tasks. Work that does not fit, going by estimateMicros(), is
+ *            left due and picked up by the next call
+ *    @param  budgetMicros Longest this call may spend on the bus
+ *    @return True if all due work was done, false if some was carried over
+ */
+bool Adafruit_AW9523::update(uint32_t budgetMicros) {
+  uint32_t start = micros();
+  uint32_t ms = millis();
+  bool done = true;
+
+  bool pollDue = _pollInterval && (ms - _lastPoll >= _pollInterval);
+  if (_intPending || pollDue) {
+    if (micros() - start + serviceMicros() <= budgetMicros) {
+      serviceInputs(_intPending);
+      _lastPoll = ms;
+    } else {
+      done = false;
+    }
+  }
+
+  if (_healthInterval && (ms - _lastHealth >= _healthInterval)) {
+    if (micros() - start + estimateMicros(1, 1) <= budgetMicros) {
+      AW9523_TRACE_SPAN("health", NULL);
+      uint8_t id;
+      _healthy = readField<AW9523_CHIPID>(&id) && (id == 0x23);
+      _lastHealth = ms;
+    } else {
+      done = false;
+    }
+  }
+
+  for (Adafruit_AW9523_Task *task = _tasks; task; task = task->nextTask) {
+    uint32_t now = micros();
+    uint32_t cost = task->taskCost(now);
+    if (!cost) {
+      continue;
+    }
+    if (now - start + cost <= budgetMicros) {
+      task->taskRun(now);
+    } else {
+      done = false;
+    }
+  }
+
+  return done;
+}
+
+/*!
+ *    @brief  Adds background work for update() to run, after any already
+ *            added. A task must only be added once
+ *    @param  task The work to add
+ */
+void Adafruit_AW9523::addTask(Adafruit_AW9523_Task *task) {
+  Adafruit_AW9523_Task **last = &_tasks;
+  while (*last) {
+    last = &(*last)->nextTask;
+  }
+  task->nextTask = NULL;
+  *last = task;
+}
+
+/*!
+ *    @brief  Makes update() read the inputs and run the change callback
+ *            every so often, for boards without the INT line wired
+ *    @param  ms Milliseconds between polls, 0 to turn polling off
+ */
+void Adafruit_AW9523::setPollInterval(uint16_t ms) { _pollInterval = ms; }
+
+/*!
+ *    @brief  Makes update() check every so often that the chip still
+ *            answers with the right ID
+ *    @param  ms Milliseconds between checks, 0 to turn checking off
+ */
+void Adafruit_AW9523::setHealthCheckInterval(uint16_t ms) {
+  _healthInterval = ms;
+}
+
+/*!
+ *    @brief  Result of the last health check made by update()
+ *    @return True if the chip answered with the right ID
+ */
+bool Adafruit_AW9523::healthy(void) { return _healthy; }
+
+/*!
+ *    @brief  Sets the bus cost model used by estimateMicros()
+ *    @param  clockHz I2C bus clock, e.g. 100000 or 400000
+ *    @param  overheadMicros Fixed host-side cost of each transfer
+ */
+void Adafruit_AW9523::setBusCost(uint32_t clockHz, uint16_t overheadMicros) {
+  _busClock = clockHz;
+  _busOverhead = overheadMicros;
+}
+
+/*!
+ *    @brief  Estimates how long one transfer takes on the bus
+ *    @param  writeBytes Bytes written, including the register address
+ *    @param  readBytes Bytes read back after a repeated start, if any
+ *    @return Estimated microseconds for the transfer
+ */
+uint32_t Adafruit_AW9523::estimateMicros(uint8_t writeBytes,
+                                         uint8_t readBytes) {
+  // 9 clocks a byte, plus the address byte(s) and start/stop conditions
+  uint32_t clocks = 9UL * (1 + writeBytes) + 2;
+  if (readBytes) {
+    clocks += 9UL * (1 + readBytes) + 1;
+  }
+  return (clocks * 1000000UL + _busClock - 1) / _busClock + _busOverhead;
+}
+
+#ifdef AW9523_LATENCY_STATS
+/*!
+ *    @brief  Gets the latency distributions collected by service()
+ *    @return A copy of the collected statistics
+ */
+aw9523_latency_t Adafruit_AW9523::latencyStats(void) { return _latency; }
+
+/*!
+ *    @brief  Clears the latency distributions
+ */
+void Adafruit_AW9523::clearLatencyStats(void) {
+  memset(&_latency, 0, sizeof(_latency));
+}
+
+/*!
+ *    @brief  Prints the latency distributions, one line per stage with the
+ *            mean, the max and the count in each power-of-two bucket
+ *    @param  out Where to print, e.g. Serial
+ */
+void Adafruit_AW9523::printLatencyStats(Print &out) {
+  static const char *const names[AW9523_LATENCY_STAGES] = {
+      "edge->service", "service->read", "read->callback"};
+
+  for (uint8_t s = 0; s < AW9523_LATENCY_STAGES; s++) {
+    out.print(names[s]);
+    out.print(" mean=");
+    out.print(_latency.samples ? _latency.total[s] / _latency.samples : 0);
+    out.print("us max=");
+    out.print(_latency.max[s]);
+    out.print("us buckets=");
+    for (uint8_t b = 0; b < AW9523_LATENCY_BUCKETS; b++) {
+      out.print(' ');
+      out.print(_latency.histogram[s][b]);
+    }
+    out.println();
+  }
+}
+
+/*!
+ *    @brief  Adds one sample to a stage's distribution
+ *    @param  stage Which aw9523_latency_stage_t the sample is for
+ *    @param  micros The sample, in microseconds
+ */
+void Adafruit_AW9523::recordLatency(uint8_t stage, uint32_t micros) {
+  uint8_t bucket = 0;
+  while ((micros >> (bucket + 1)) && (bucket < AW9523_LATENCY_BUCKETS - 1)) {
+    bucket++;
+  }
+  if (_latency.histogram[stage][bucket] != 0xFFFF) {
+    _latency.histogram[stage][bucket]++;
+  }
+  if (micros > _latency.max[stage]) {
+    _latency.max[stage] = micros;
+  }
+  _latency.total[stage] += micros;
+}
+#endif
+
+/*!
+ *    @brief  Reads consecutive registers in one I2C transaction
+ *    @param  reg First register to read
+ *    @param  buffer Where to put the register values
+ *    @param  len Number of registers to read
+ *    @return True if the read was acknowledged
+ */
+bool Adafruit_AW9523::readRegisters(uint8_t reg, uint8_t *buffer,
+                                    uint8_t len) {
+  AW9523_TRACE_SPAN("read", bus());
+#ifdef AW9523_FAULT_INJECTION
+  uint8_t fault = injectFault();
+  if (fault && (fault != 3)) { // corruption only hits writes
+    _stats.transfers++;
+    _stats.errors++;
+    _busError = true;
+    return false;
+  }
+#endif
+  _stats.transfers++;
+  if (!busWriteThenRead(&reg, 1, buffer, len)) {
+    _stats.errors++;
+    _busError = true;
+    return false;
+  }
+  _stats.bytesWritten++;
+  _stats.bytesRead += len;
+  return true;
+}
+
+/*!
+ *    @brief  Writes bytes to the chip on whichever bus it is on
+ *    @param  buffer Bytes to write
+ *    @param  len Number of bytes in buffer
+ *    @param  stop False to keep the bus with a repeated start afterwards
+ *    @param  prefix Bytes to write first, e.g. the register address
+ *    @param  prefixLen Number of bytes in prefix
+ *    @return True if the write was acknowledged
+ */
+bool Adafruit_AW9523::busWrite(const uint8_t *buffer, uint8_t len, bool stop,
+                               const uint8_t *prefix, uint8_t prefixLen) {
+  if (_soft) {
+    return _soft->write(_address, buffer, len, stop, prefix, prefixLen);
+  }
+  return i2c_dev->write(buffer, len, stop, prefix, prefixLen);
+}
+
+/*!
+ *    @brief  Writes bytes to the chip then reads from it, on whichever bus
+ *            it is on
+ *    @param  writeBuffer Bytes to write, e.g. the register address
+ *    @param  writeLen Number of bytes to write
+ *    @param  readBuffer Where to put the bytes read
+ *    @param  readLen Number of bytes to read
+ *    @return True if the transfer was acknowledged
+ */
+bool Adafruit_AW9523::busWriteThenRead(const uint8_t *writeBuffer,
+                                       uint8_t writeLen, uint8_t *readBuffer,
+                                       uint8_t readLen) {
+  if (_soft) {
+    return _soft->writeThenRead(_address, writeBuffer, writeLen, readBuffer,
+                                readLen);
+  }
+  return i2c_dev->write_then_read(writeBuffer, writeLen, readBuffer, readLen);
+}
+
+/*!
+ *    @brief  Writes consecutive registers in one I2C transaction
+ *    @param  reg First register to write
+ *    @param  buffer Register values to write
+ *    @param  len Number of registers to write
+ *    @param  stop False to keep the bus with a repeated start afterwards
+ *    @return True if the write was acknowledged
+ */
+bool Adafruit_AW9523::writeRegisters(uint8_t reg, const uint8_t *buffer,
+                                     uint8_t len, bool stop) {
+  AW9523_TRACE_SPAN("write", bus());
+  const uint8_t *sent = buffer;
+#ifdef AW9523_FAULT_INJECTION
+  uint8_t fault = injectFault();
+  uint8_t corrupted[16];
+  if (fault == 3) {
+    // flipped on the wire, the chip acknowledges it all the same
+    if (len && (len <= sizeof(corrupted))) {
+      memcpy(corrupted, buffer, len);
+      corrupted[len - 1] ^= 0x01;
+      sent = corrupted;
+    }
+    fault = 0;
+  }
+  if (fault == 2) {
+    // arbitration lost part way, the first bytes may still have landed
+    busWrite(buffer, len / 2, true, &reg, 1);
+  }
+  if (fault) {
+    _stats.transfers++;
+    _stats.errors++;
+    _busError = true;
+    return false;
+  }
+#endif
+  _stats.transfers++;
+  if (!busWrite(sent, len, stop, &reg, 1)) {
+    _stats.errors++;
+    _busError = true;
+    return false;
+  }
+  _stats.bytesWritten += len + 1;
+
+  // keep our copy of the outputs in step with every write that hits them
+  if ((reg <= AW9523_REG_OUTPUT1) && (reg + len > AW9523_REG_OUTPUT0)) {
+    for (uint8_t i = 0; i < len; i++) {
+      if (reg + i == AW9523_REG_OUTPUT0) {
+        _outputs = (_outputs & 0xFF00) | buffer[i];
+      } else if (reg + i == AW9523_REG_OUTPUT1) {
+        _outputs = (_outputs & 0x00FF) | ((uint16_t)buffer[i] << 8);
+      }
+    }
+  }
+
+  // a read back now would split a chain held with repeated STARTs, so
+  // chained writes are left for the chain's owner to verify at its end
+  return stop ? verifyRegisters(reg, buffer, len) : true;
+}
+
+/*!
+ *    @brief  Reads back registers just written, if verify-after-write is on,
+ *            in one burst
+ *    @param  reg First register written
+ *    @param  buffer Register values written
+ *    @param  len Number of registers written
+ *    @return False if verifying and the chip does not hold what was written
+ */
+bool Adafruit_AW9523::verifyRegisters(uint8_t reg, const uint8_t *buffer,
+                                      uint8_t len) {
+  // dimming registers are write only and soft reset reads back as zero
+  if (!_verify || (len > 16) || (reg >= 0x20) || (reg + len > 0x20)) {
+    return true;
+  }
+
+  uint8_t readback[16];
+  _stats.verifyReads++;
+  _stats.verifyBytes += len;
+  if (!busWriteThenRead(&reg, 1, readback, len) ||
+      memcmp(buffer, readback, len)) {
+    _stats.verifyFailures++;
+    _busError = true;
+    return false;
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Turns verify-after-write on or off. When on, every register
+ *            write is read back in a single burst covering the whole range
+ *            just written, and fails if the chip does not hold what was
+ *            sent. Dimming registers are write only and are not verified.
+ *            A group reads back its chained writes once the chain has let
+ *            go of the bus, so chains stay whole
+ *    @param  verify True to read back writes
+ */
+void Adafruit_AW9523::setVerifyWrites(bool verify) { _verify = verify; }
+
+/*!
+ *    @brief  Gets the bus traffic counted since the chip object was made or
+ *            since clearStats()
+ *    @return A copy of the counters
+ */
+aw9523_stats_t Adafruit_AW9523::stats(void) { return _stats; }
+
+/*!
+ *    @brief  Zeroes the bus traffic counters
+ */
+void Adafruit_AW9523::clearStats(void) { memset(&_stats, 0, sizeof(_stats)); }
+
+/*!
+ *    @brief  Read-modify-write of some bits in one register
+ *    @param  reg Register to update
+ *    @param  mask Bits to change
+ *    @param  value New values for the bits in mask
+ *    @return True if both the read and the write were acknowledged
+ */
+bool Adafruit_AW9523::updateRegister(uint8_t reg, uint8_t mask,
+                                     uint8_t value) {
+  uint8_t current;
+
+  if (!readRegisters(reg, &current, 1)) {
+    return false;
+  }
+  current = (current & ~mask) | (value & mask);
+  return writeRegisters(reg, &current, 1);
+}
+
+/*!
+ *    @brief  Gets the chip's I2C address
+ *    @return The address given to begin(), or 0 before begin()
+ */
+uint8_t Adafruit_AW9523::address(void) { return _address; }
+
+/*!
+ *    @brief  Prints the start of a metric family, for printMetrics() and
+ *            the helper classes' own metrics
+ *    @param  out Where to print
+ *    @param  name Family name
+ *    @param  type OpenMetrics type, e.g. "counter"
+ *    @param  help One line description
+ */
+void Adafruit_AW9523::printMetricFamily(Print &out, const char *name,
+                                        const char *type, const char *help) {
+  out.print("# TYPE ");
+  out.print(name);
+  out.print(' ');
+  out.println(type);
+  out.print("# HELP ");
+  out.print(name);
+  out.print(' ');
+  out.println(help);
+}
+
+/*!
+ *    @brief  Prints a sample name and the chip labels, up to the closing
+ *            brace, so more labels can follow
+ *    @param  out Where to print
+ *    @param  name Family name
+ *    @param  suffix Sample suffix, e.g. "_total"
+ *    @param  index Position of the chip in the list
+ *    @param  address I2C address of the chip
+ */
+void Adafruit_AW9523::printMetricLabels(Print &out, const char *name,
+                                        const char *suffix, uint8_t index,
+                                        uint8_t address) {
+  out.print(name);
+  out.print(suffix);
+  out.print("{chip=\"");
+  out.print(index);
+  out.print("\",address=\"0x");
+  out.print(address, HEX);
+  out.print('"');
+}
+
+/*!
+ *    @brief  Prints the statistics of several chips in OpenMetrics text
+ *            format, for a scraper reading a serial port, file or socket.
+ *            Each chip's counters are copied before printing, nothing
+ *            waits on the bus. End the exposition with a "# EOF" line once
+ *            everything else to go in it has been printed
+ *    @param  out Where to print, e.g. Serial
+ *    @param  chips The chips, each labelled with its position and address
+ *    @param  count Number of chips
+ */
+void Adafruit_AW9523::printMetrics(Print &out, Adafruit_AW9523 *const *chips,
+                                   uint8_t count) {
+  static const struct {
+    const char *name;
+    const char *help;
+    uint8_t offset;
+  } counters[] = {
+      {"aw9523_transfers", "I2C transfers",
+       offsetof(aw9523_stats_t, transfers)},
+      {"aw9523_written_bytes", "Bytes written",
+       offsetof(aw9523_stats_t, bytesWritten)},
+      {"aw9523_read_bytes", "Bytes read",
+       offsetof(aw9523_stats_t, bytesRead)},
+      {"aw9523_errors", "Transfers not acknowledged",
+       offsetof(aw9523_stats_t, errors)},
+      {"aw9523_verify_reads", "Reads made to verify writes",
+       offsetof(aw9523_stats_t, verifyReads)},
+      {"aw9523_verify_failures", "Writes that did not read back the same",
+       offsetof(aw9523_stats_t, verifyFailures)},
+  };
+
+  for (uint8_t m = 0; m < sizeof(counters) / sizeof(counters[0]); m++) {
+    printMetricFamily(out, counters[m].name, "counter", counters[m].help);
+    for (uint8_t c = 0; c < count; c++) {
+      aw9523_stats_t stats = chips[c]->stats();
+      printMetricLabels(out, counters[m].name, "_total", c,
+                        chips[c]->address());
+      out.print("} ");
+      out.println(*(uint32_t *)((uint8_t *)&stats + counters[m].offset));
+    }
+  }
+
+  printMetricFamily(out, "aw9523_interrupts", "counter",
+                    "INT edges passed to interruptTriggered()");
+  for (uint8_t c = 0; c < count; c++) {
+    noInterrupts();
+    uint32_t edges = chips[c]->_intCount;
+    interrupts();
+    printMetricLabels(out, "aw9523_interrupts", "_total", c,
+                      chips[c]->address());
+    out.print("} ");
+    out.println(edges);
+  }
+
+  printMetricFamily(out, "aw9523_healthy", "gauge",
+                    "1 if the chip answered its last ID check");
+  for (uint8_t c = 0; c < count; c++) {
+    printMetricLabels(out, "aw9523_healthy", "", c, chips[c]->address());
+    out.print("} ");
+    out.println(chips[c]->healthy() ? 1 : 0);
+  }
+
+#ifdef AW9523_LATENCY_STATS
+  static const char *const stages[AW9523_LATENCY_STAGES] = {
+      "edge_to_service", "service_to_read", "read_to_callback"};
+
+  printMetricFamily(out, "aw9523_latency_microseconds", "histogram",
+                    "Time from an INT edge through to the change callback");
+  for (uint8_t c = 0; c < count; c++) {
+    aw9523_latency_t latency = chips[c]->latencyStats();
+    for (uint8_t s = 0; s < AW9523_LATENCY_STAGES; s++) {
+      // buckets are counts per power of two, OpenMetrics wants running totals
+      uint32_t total = 0;
+      for (uint8_t b = 0; b < AW9523_LATENCY_BUCKETS; b++) {
+        total += latency.histogram[s][b];
+        printMetricLabels(out, "aw9523_latency_microseconds", "_bucket", c,
+                          chips[c]->address());
+        out.print(",stage=\"");
+        out.print(stages[s]);
+        out.print("\",le=\"");
+        if (b < AW9523_LATENCY_BUCKETS - 1) {
+          out.print((1UL << (b + 1)) - 1);
+        } else {
+          out.print("+Inf");
+        }
+        out.print("\"} ");
+        out.println(total);
+      }
+      printMetricLabels(out, "aw9523_latency_microseconds", "_count", c,
+                        chips[c]->address());
+      out.print(",stage=\"");
+      out.print(stages[s]);
+      out.print("\"} ");
+      out.println(total);
+      printMetricLabels(out, "aw9523_latency_microseconds", "_sum", c,
+                        chips[c]->address());
+      out.print(",stage=\"");
+      out.print(stages[s]);
+      out.print("\"} ");
+      out.println(latency.total[s]);
+    }
+  }
+#endif
+}
+
+#ifdef AW9523_FAULT_INJECTION
+/*!
+ *    @brief  Sets how often faults are injected into bus transfers, for
+ *            benchmarking the recovery paths. Faults are injected on the
+ *            driver side of the bus, so a NACK or arbitration loss fails the
+ *            transfer without touching the chip, a reset really resets it
+ *            and a corrupted write really lands with a bit flipped
+ *    @param  rates Chance of each fault per transfer, out of 65535
+ *    @param  seed Non-zero seed, the same seed gives the same fault pattern.
+ *            Also zeroes faultCounts()
+ */
+void Adafruit_AW9523::setFaultRates(const aw9523_fault_rates_t &rates,
+                                    uint16_t seed) {
+  _faultRates = rates;
+  _faultSeed = seed ? seed : 1;
+  _stuck = false;
+  memset(&_faultCounts, 0, sizeof(_faultCounts));
+}
+
+/*!
+ *    @brief  Gets the number of faults injected since setFaultRates()
+ *    @return Counts for each kind of fault
+ */
+aw9523_fault_counts_t Adafruit_AW9523::faultCounts(void) {
+  return _faultCounts;
+}
+
+/*!
+ *    @brief  Decides whether the next transfer gets a fault
+ *    @return 0 to carry on, 1 to fail the transfer, 2 to cut it short, 3
+ *            to flip a data bit
+ */
+uint8_t Adafruit_AW9523::injectFault(void) {
+  if (_stuck) {
+    if ((int32_t)(micros() - _stuckUntil) < 0) {
+      _faultCounts.stuck++;
+      return 1;
+    }
+    _stuck = false;
+  }
+
+  if (faultRoll(_faultRates.reset)) {
+    uint8_t reset[2] = {AW9523_REG_SOFTRESET, 0};
+    busWrite(reset, 2, true, NULL, 0);
+    _faultCounts.reset++;
+  }
+  if (faultRoll(_faultRates.stretch)) {
+    delayMicroseconds(_faultRates.stretchMicros);
+    _faultCounts.stretch++;
+  }
+  if (faultRoll(_faultRates.stuck)) {
+    _stuck = true;
+    _stuckUntil = micros() + _faultRates.stuckMicros;
+    _faultCounts.stuck++;
+    return 1;
+  }
+  if (faultRoll(_faultRates.nack)) {
+    _faultCounts.nack++;
+    return 1;
+  }
+  if (faultRoll(_faultRates.arbitration)) {
+    _faultCounts.arbitration++;
+    return 2;
+  }
+  if (faultRoll(_faultRates.corrupt)) {
+    _faultCounts.corrupt++;
+    return 3;
+  }
+  return 0;
+}
+
+/*!
+ *    @brief  Rolls the fault dice once
+ *    @param  rate Chance of a hit, out of 65535
+ *    @return True on a hit
+ */
+bool Adafruit_AW9523::faultRoll(uint16_t rate) {
+  // xorshift16, cheap and repeatable
+  _faultSeed ^= _faultSeed << 7;
+  _faultSeed ^= _faultSeed >> 9;
+  _faultSeed ^= _faultSeed << 8;
+  // the state is never 0, so take 1 off to cover 0 to 65534 evenly
+  return (uint16_t)(_faultSeed - 1) < rate;
 }
+#endif
@@ -39,35 +39,371 @@
 #define AW9523_REG_LEDMODE0 0x12    ///< Register for configuring const current on Port0
 #define AW9523_REG_LEDMODE1 0x13    ///< Register for configuring const current on Port1
 
+/*!
+ *    @brief  Dimming register for a pin, see Table 13 of the datasheet
+ *    @param  pin GPIO from 0 to 15 inclusive
+ *    @return Register address
+ */
+constexpr uint8_t AW9523_dimRegister(uint8_t pin) {
+  return (pin <= 7)    ? 0x24 + pin
+         : (pin <= 11) ? 0x20 + pin - 8
+                       : 0x2C + pin - 12;
+}
+
+/*!
+ *    @brief  Compile-time description of a bitfield within one register
+ *    @tparam REG Register address
+ *    @tparam SHIFT Position of the field's lowest bit
+ *    @tparam BITS Width of the field
+ */
+template <uint8_t REG, uint8_t SHIFT = 0, uint8_t BITS = 8>
+struct Adafruit_AW9523_Field {
+  static constexpr uint8_t reg = REG;     ///< Register address
+  static constexpr uint8_t shift = SHIFT; ///< Position of the lowest bit
+  static constexpr uint8_t mask =
+      (uint8_t)(((1U << BITS) - 1) << SHIFT); ///< Field bits in place
+};
+
+/*!
+ *    @brief  Compile-time description of a Port0/Port1 register pair,
+ *            accessed as one 16-bit value with Port0 in the low byte
+ *    @tparam REG Address of the Port0 register
+ */
+template <uint8_t REG> struct Adafruit_AW9523_Register16 {
+  static constexpr uint8_t reg = REG; ///< Address of the Port0 register
+};
+
+/// Chip ID, reads 0x23
+typedef Adafruit_AW9523_Field<AW9523_REG_CHIPID> AW9523_CHIPID;
+/// GCR LED current range, 0 == Imax, 1 == 3/4, 2 == 1/2, 3 == 1/4 Imax
+typedef Adafruit_AW9523_Field<AW9523_REG_GCR, 0, 2> AW9523_GCR_ISEL;
+/// GCR Port0 output mode, 0 == open drain, 1 == push-pull
+typedef Adafruit_AW9523_Field<AW9523_REG_GCR, 4, 1> AW9523_GCR_GPOMD;
+/// Input levels, 1 == high
+typedef Adafruit_AW9523_Register16<AW9523_REG_INPUT0> AW9523_INPUT;
+/// Output levels, 1 == high
+typedef Adafruit_AW9523_Register16<AW9523_REG_OUTPUT0> AW9523_OUTPUT;
+/// Direction, 1 == input
+typedef Adafruit_AW9523_Register16<AW9523_REG_CONFIG0> AW9523_CONFIG;
+/// Interrupt disable, 1 == no interrupt
+typedef Adafruit_AW9523_Register16<AW9523_REG_INTENABLE0> AW9523_INTENABLE;
+/// Pin mode, 1 == GPIO, 0 == constant current LED
+typedef Adafruit_AW9523_Register16<AW9523_REG_LEDMODE0> AW9523_LEDMODE;
+
+/*!
+ *    @brief  Dimming register for one pin
+ *    @tparam PIN GPIO from 0 to 15 inclusive
+ */
+template <uint8_t PIN>
+struct AW9523_DIM : Adafruit_AW9523_Field<AW9523_dimRegister(PIN)> {};
+
+/*!
+ *    @brief  Bus traffic counted by the driver. Byte counts include register
+ *            address bytes but not the I2C address
+ */
+typedef struct {
+  uint32_t transfers;      ///< Transfers started, not counting verify reads
+  uint32_t bytesWritten;   ///< Bytes written
+  uint32_t bytesRead;      ///< Bytes read, not counting verify reads
+  uint32_t errors;         ///< Transfers that were not acknowledged
+  uint32_t verifyReads;    ///< Burst reads made to verify writes
+  uint32_t verifyBytes;    ///< Bytes read to verify writes
+  uint32_t verifyFailures; ///< Writes that did not read back the same
+} aw9523_stats_t;
+
+/*!
+ *    @brief  Callback run by service() when inputs change
+ *    @param  changed 16-bits of pins that changed since the last read
+ *    @param  inputs 16-bits of current input values
+ */
+typedef void (*aw9523_callback_t)(uint16_t changed, uint16_t inputs);
+
+/*!
+ *    @brief  Background work that Adafruit_AW9523::update() runs when it
+ *            fits in the tick's time budget
+ */
+class Adafruit_AW9523_Task {
+public:
+  /*!
+   *    @brief  Estimates the cost of the work that is due now
+   *    @param  now Current micros()
+   *    @return Estimated microseconds, or 0 if nothing is due
+   */
+  virtual uint32_t taskCost(uint32_t now) = 0;
+  /*!
+   *    @brief  Does the work that is due now
+   *    @param  now Current micros()
+   */
+  virtual void taskRun(uint32_t now) = 0;
+
+  Adafruit_AW9523_Task *nextTask = NULL; ///< Next task on the same expander
+};
+
+#ifdef AW9523_LATENCY_STATS
+#define AW9523_LATENCY_BUCKETS 16 ///< Power-of-two microsecond buckets
+
+/*!
+ *    @brief  Stages between an INT edge and the user callback having run.
+ *            The last stage includes the callback itself, and is just the
+ *            dispatch overhead on edges with no callback to run
+ */
+typedef enum {
+  AW9523_LATENCY_EDGE_TO_SERVICE, ///< INT edge until service() is entered
+  AW9523_LATENCY_SERVICE_TO_READ, ///< service() entry until inputs are read
+  AW9523_LATENCY_READ_TO_CALLBACK, ///< inputs read until callback returns
+  AW9523_LATENCY_STAGES,           ///< Number of stages
+} aw9523_latency_stage_t;
+
+/*!
+ *    @brief  Latency distribution for each stage. Bucket n counts samples
+ *            from 2^n up to 2^(n+1) microseconds, bucket 0 also holds 0us
+ */
+typedef struct {
+  uint16_t histogram[AW9523_LATENCY_STAGES]
+                    [AW9523_LATENCY_BUCKETS]; ///< Samples per bucket
+  uint32_t max[AW9523_LATENCY_STAGES];        ///< Slowest sample, in us
+  uint32_t total[AW9523_LATENCY_STAGES];      ///< Sum of samples, in us
+  uint32_t samples;                           ///< Number of serviced edges
+} aw9523_latency_t;
+#endif
+
+#ifdef AW9523_FAULT_INJECTION
+/*!
+ *    @brief  Fault rates for the fault injection test mode. Each rate is the
+ *            chance per bus transfer, out of 65535, of that fault occurring,
+ *            so 65535 faults every transfer
+ */
+typedef struct {
+  uint16_t nack;          ///< Transfer is not acknowledged
+  uint16_t arbitration;   ///< Transfer is cut short as if arbitration was lost
+  uint16_t stretch;       ///< Transfer is delayed by stretchMicros
+  uint16_t stuck;         ///< SDA held low, bus unusable for stuckMicros
+  uint16_t reset;         ///< Chip soft-resets itself ahead of the transfer
+  uint16_t stretchMicros; ///< Length of one injected clock stretch
+  uint16_t stuckMicros;   ///< Length of one injected stuck-low episode
+  uint16_t corrupt;       ///< A written data bit flips, the chip still ACKs
+} aw9523_fault_rates_t;
+
+/*!
+ *    @brief  Number of faults of each kind injected so far
+ */
+typedef struct {
+  uint32_t nack;        ///< Transfers failed with an injected NACK
+  uint32_t arbitration; ///< Transfers cut short by injected arbitration loss
+  uint32_t stretch;     ///< Transfers delayed by an injected clock stretch
+  uint32_t stuck;       ///< Transfers failed while SDA was held low
+  uint32_t reset;       ///< Injected spontaneous chip resets
+  uint32_t corrupt;     ///< Writes that landed with a data bit flipped
+} aw9523_fault_counts_t;
+#endif
+
+class Adafruit_AW9523_SoftI2C;
+
 /*!
  *    @brief  Class that stores state and functions for interacting with
  *            the AW9523 I2C GPIO expander
  */
 class Adafruit_AW9523 {
+  friend class Adafruit_AW9523_Group;
+
 public:
   Adafruit_AW9523();
   ~Adafruit_AW9523();
 
   bool begin(uint8_t address = AW9523_DEFAULT_ADDR, TwoWire *wire = &Wire);
+  bool begin(uint8_t address, Adafruit_AW9523_SoftI2C *soft);
   bool reset(void);
   bool openDrainPort0(bool od);
 
   // All 16 pins at once
   bool outputGPIO(uint16_t pins);
+  bool outputGPIOMasked(uint16_t pins, uint16_t mask);
+  bool outputPort(uint8_t port, uint8_t pins);
+  uint16_t outputs(void);
   uint16_t inputGPIO(void);
   bool configureDirection(uint16_t pins);
   bool configureLEDMode(uint16_t pins);
   bool interruptEnableGPIO(uint16_t pins);
+  bool analogWriteGPIO(const uint8_t *vals);
 
   // Individual pin control
-  void pinMode(uint8_t pin, uint8_t mode);
-  void digitalWrite(uint8_t pin, bool val);
+  bool pinMode(uint8_t pin, uint8_t mode);
+  bool digitalWrite(uint8_t pin, bool val);
   bool digitalRead(uint8_t pin);
-  void analogWrite(uint8_t pin, uint8_t val);
-  void enableInterrupt(uint8_t pin, bool en);
+  bool analogWrite(uint8_t pin, uint8_t val);
+  bool enableInterrupt(uint8_t pin, bool en);
+
+  // Sticky error, set by any failed transfer
+  bool busError(void);
+  void clearBusError(void);
+
+  uint8_t address(void);
+  void setVerifyWrites(bool verify);
+  aw9523_stats_t stats(void);
+  void clearStats(void);
+  static void printMetrics(Print &out, Adafruit_AW9523 *const *chips,
+                           uint8_t count);
+  static void printMetricFamily(Print &out, const char *name,
+                                const char *type, const char *help);
+  static void printMetricLabels(Print &out, const char *name,
+                                const char *suffix, uint8_t index,
+                                uint8_t address);
+
+  // Interrupt servicing
+  void interruptTriggered(void);
+  void onChange(aw9523_callback_t callback, uint16_t pins = 0xFFFF);
+  bool service(void);
+  void setInterest(uint16_t pins);
+  uint16_t interest(void);
+  uint32_t serviceMicros(void);
+
+  // Cooperative background work
+  bool update(uint32_t budgetMicros);
+  void addTask(Adafruit_AW9523_Task *task);
+  void setPollInterval(uint16_t ms);
+  void setHealthCheckInterval(uint16_t ms);
+  bool healthy(void);
+  void setBusCost(uint32_t clockHz, uint16_t overheadMicros);
+  uint32_t estimateMicros(uint8_t writeBytes, uint8_t readBytes = 0);
+
+  // Typed register access
+
+  /*!
+   *    @brief  Writes a register or bitfield, e.g.
+   *            writeField<AW9523_GCR_ISEL>(2). Whole registers take one
+   *            write, narrower fields a read and a write
+   *    @tparam FIELD An Adafruit_AW9523_Field descriptor
+   *    @param  value New field value, not shifted
+   *    @return True if the transfers were acknowledged
+   */
+  template <class FIELD> bool writeField(uint8_t value) {
+    if (FIELD::mask == 0xFF) {
+      return writeRegisters(FIELD::reg, &value, 1);
+    }
+    return updateRegister(FIELD::reg, FIELD::mask, value << FIELD::shift);
+  }
+
+  /*!
+   *    @brief  Reads a register or bitfield in one transfer
+   *    @tparam FIELD An Adafruit_AW9523_Field descriptor
+   *    @param  value Where to put the field value, not shifted
+   *    @return True if the read was acknowledged
+   */
+  template <class FIELD> bool readField(uint8_t *value) {
+    uint8_t reg;
+    if (!readRegisters(FIELD::reg, &reg, 1)) {
+      return false;
+    }
+    *value = (reg & FIELD::mask) >> FIELD::shift;
+    return true;
+  }
+
+  /*!
+   *    @brief  Writes both ports of a register pair in one transfer
+   *    @tparam REG16 An Adafruit_AW9523_Register16 descriptor
+   *    @param  value Port0 in the low byte, Port1 in the high byte
+   *    @return True if the write was acknowledged
+   */
+  template <class REG16> bool writeRegister16(uint16_t value) {
+    uint8_t buffer[2] = {(uint8_t)value, (uint8_t)(value >> 8)};
+    return writeRegisters(REG16::reg, buffer, 2);
+  }
+
+  /*!
+   *    @brief  Reads both ports of a register pair in one transfer
+   *    @tparam REG16 An Adafruit_AW9523_Register16 descriptor
+   *    @param  value Where to put Port0 (low byte) and Port1 (high byte)
+   *    @return True if the read was acknowledged
+   */
+  template <class REG16> bool readRegister16(uint16_t *value) {
+    uint8_t buffer[2];
+    if (!readRegisters(REG16::reg, buffer, 2)) {
+      return false;
+    }
+    *value = ((uint16_t)buffer[1] << 8) | buffer[0];
+    return true;
+  }
+
+#ifdef AW9523_LATENCY_STATS
+  aw9523_latency_t latencyStats(void);
+  void clearLatencyStats(void);
+  void printLatencyStats(Print &out);
+#endif
+
+#ifdef AW9523_FAULT_INJECTION
+  void setFaultRates(const aw9523_fault_rates_t &rates, uint16_t seed = 1);
+  aw9523_fault_counts_t faultCounts(void);
+#endif
 
 protected:
+  bool attach(uint8_t addr, TwoWire *wire, bool detect);
+  bool init(void);
+  bool busWrite(const uint8_t *buffer, uint8_t len, bool stop,
+                const uint8_t *prefix, uint8_t prefixLen);
+  bool busWriteThenRead(const uint8_t *writeBuffer, uint8_t writeLen,
+                        uint8_t *readBuffer, uint8_t readLen);
+
+  /*!
+   *    @brief  Identifies the bus the chip is on, to tell chips on the same
+   *            bus apart from the rest
+   *    @return The Wire or bit-banged bus object
+   */
+  const void *bus(void) {
+    return _soft ? (const void *)_soft : (const void *)_wire;
+  }
+  bool readRegisters(uint8_t reg, uint8_t *buffer, uint8_t len);
+  bool writeRegisters(uint8_t reg, const uint8_t *buffer, uint8_t len,
+                      bool stop = true);
+  bool verifyRegisters(uint8_t reg, const uint8_t *buffer, uint8_t len);
+  bool updateRegister(uint8_t reg, uint8_t mask, uint8_t value);
+
   Adafruit_I2CDevice *i2c_dev = NULL; ///< Pointer to I2C bus interface
+  TwoWire *_wire = NULL;              ///< Bus the chip is on
+  Adafruit_AW9523_SoftI2C *_soft = NULL; ///< Bit-banged bus instead of Wire
+  uint8_t _address = 0;                  ///< I2C address of the chip
+  bool _busError = false; ///< A transfer failed since clearBusError()
+  bool _verify = false;   ///< Read back every write
+  uint16_t _outputs = 0;  ///< Last value written to the OUTPUT registers
+  aw9523_stats_t _stats = {0, 0, 0, 0, 0, 0, 0}; ///< Bus traffic counters
+
+  void serviceInputs(bool interrupt);
+
+  aw9523_callback_t _callback = NULL; ///< Called by service() on change
+  uint16_t _callbackPins = 0xFFFF;    ///< Pins the callback wants
+  uint16_t _interest = 0;             ///< Pins declared by setInterest()
+  uint16_t _intEnabled = 0xFFFF;      ///< Pins with INT enabled
+  uint16_t _lastInputs = 0;           ///< Inputs as of the last service()
+  volatile bool _intPending = false;  ///< Set by interruptTriggered()
+  volatile uint32_t _intMicros = 0;   ///< micros() of the latest INT edge
+  volatile uint32_t _intCount = 0;    ///< INT edges seen
+
+  Adafruit_AW9523_Task *_tasks = NULL; ///< Extra work for update()
+  uint16_t _pollInterval = 0;          ///< ms between input polls, 0 == off
+  uint16_t _healthInterval = 0;        ///< ms between ID checks, 0 == off
+  uint32_t _lastPoll = 0;              ///< millis() of the last input poll
+  uint32_t _lastHealth = 0;            ///< millis() of the last ID check
+  bool _healthy = true;                ///< Chip answered the last ID check
+  uint32_t _busClock = 100000;         ///< Bus clock for the cost model
+  uint16_t _busOverhead = 20;          ///< Per-transfer software overhead
+
+#ifdef AW9523_LATENCY_STATS
+  void recordLatency(uint8_t stage, uint32_t micros);
+
+  aw9523_latency_t _latency; ///< Collected latency distributions
+#endif
+
+#ifdef AW9523_FAULT_INJECTION
+  uint8_t injectFault(void);
+  bool faultRoll(uint16_t rate);
+
+  /// Active rates
+  aw9523_fault_rates_t _faultRates = {0, 0, 0, 0, 0, 0, 0, 0};
+  /// Injected so far
+  aw9523_fault_counts_t _faultCounts = {0, 0, 0, 0, 0, 0};
+  uint16_t _faultSeed = 1;       ///< xorshift state for fault decisions
+  uint32_t _stuckUntil = 0;      ///< micros() at which stuck SDA releases
+  bool _stuck = false;           ///< True while SDA is held low
+#endif
 };
 
 #endif
@@ -0,0 +1,157 @@
+/*!
+ *  @file Adafruit_AW9523_Blinker.cpp
+ *
+ * 	Phase aligned multi-pin blinking for the Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#include "Adafruit_AW9523_Blinker.h"
+
+/*!
+ *    @brief  Instantiates a blink manager
+ *    @param  aw The expander the pins are on, already begin()'d
+ */
+Adafruit_AW9523_Blinker::Adafruit_AW9523_Blinker(Adafruit_AW9523 *aw) {
+  _aw = aw;
+  memset(_period, 0, sizeof(_period));
+  memset(_onTicks, 0, sizeof(_onTicks));
+  memset(_position, 0, sizeof(_position));
+}
+
+/*!
+ *    @brief  Starts the shared tick. All periods are rounded to whole ticks,
+ *            a longer tick lines up more toggles into the same write
+ *    @param  tickMillis Tick length in milliseconds
+ */
+void Adafruit_AW9523_Blinker::begin(uint8_t tickMillis) {
+  _tickMillis = tickMillis ? tickMillis : 1;
+  _ticks = 0;
+  _lastTick = _windowStart = millis();
+  _windowWrites = _writesPerSec = 0;
+}
+
+/*!
+ *    @brief  Starts a pin blinking. Its phase is taken from the shared tick
+ *            count, so pins with the same or related periods stay in step
+ *            however late they are added
+ *    @param  pin GPIO to blink, from 0 to 15 inclusive
+ *    @param  periodMillis Length of one on/off cycle
+ *    @param  dutyPercent Part of the period spent high, from 0 to 100
+ *    @return True if the pin was made an output
+ */
+bool Adafruit_AW9523_Blinker::blink(uint8_t pin, uint16_t periodMillis,
+                                    uint8_t dutyPercent) {
+  if (pin > 15) {
+    return false;
+  }
+  uint16_t period = (periodMillis + _tickMillis / 2) / _tickMillis;
+  if (!period) {
+    period = 1;
+  }
+  _period[pin] = period;
+  if (dutyPercent > 100) {
+    dutyPercent = 100;
+  }
+  _onTicks[pin] = ((uint32_t)period * dutyPercent + 50) / 100;
+  _position[pin] = _ticks % period;
+
+  if (!(_pins & (1 << pin)) && !_aw->pinMode(pin, OUTPUT)) {
+    return false;
+  }
+  _pins |= 1 << pin;
+  return true;
+}
+
+/*!
+ *    @brief  Stops a pin blinking and leaves it at a fixed level
+ *    @param  pin GPIO to stop, from 0 to 15 inclusive
+ *    @param  level Level to leave it at
+ *    @return True I2C write command was acknowledged
+ */
+bool Adafruit_AW9523_Blinker::stop(uint8_t pin, bool level) {
+  if (pin > 15) {
+    return false;
+  }
+  _pins &= ~(1 << pin);
+  return _aw->outputGPIOMasked(level ? 0xFFFF : 0, 1 << pin);
+}
+
+/*!
+ *    @brief  Advances the blink pattern to now and writes every pin that
+ *            changed in one output write. Ticks missed by a late call are
+ *            caught up, still with a single write
+ *    @return True if a write was made
+ */
+bool Adafruit_AW9523_Blinker::run(void) {
+  uint32_t ms = millis();
+  uint32_t elapsed = (ms - _lastTick) / _tickMillis;
+
+  if (ms - _windowStart >= 1000) {
+    _writesPerSec = _windowWrites;
+    _windowWrites = 0;
+    _windowStart = ms;
+  }
+  if (!elapsed) {
+    return false;
+  }
+  _lastTick += elapsed * _tickMillis;
+  _ticks += elapsed;
+
+  uint16_t levels = 0;
+  uint16_t pins = _pins;
+  for (uint8_t pin = 0; pins; pin++, pins >>= 1) {
+    if (!(pins & 1)) {
+      continue;
+    }
+    uint16_t pos = _position[pin] + (elapsed % _period[pin]);
+    if (pos >= _period[pin]) {
+      pos -= _period[pin];
+    }
+    _position[pin] = pos;
+    if (pos < _onTicks[pin]) {
+      levels |= 1 << pin;
+    }
+  }
+
+  if (!((levels ^ _aw->outputs()) & _pins)) {
+    return false;
+  }
+  _windowWrites++;
+  _aw->outputGPIOMasked(levels, _pins);
+  return true;
+}
+
+/*!
+ *    @brief  Output writes made by run() over the last whole second
+ *    @return Writes per second
+ */
+uint16_t Adafruit_AW9523_Blinker::writesPerSecond(void) {
+  return _writesPerSec;
+}
+
+/*!
+ *    @brief  Estimates the bus cost of run() if a tick is due
+ *    @param  now Current micros()
+ *    @return Estimated microseconds, or 0 if no tick is due
+ */
+uint32_t Adafruit_AW9523_Blinker::taskCost(uint32_t now) {
+  (void)now;
+  if (!_pins || (millis() - _lastTick < _tickMillis)) {
+    return 0;
+  }
+  return _aw->estimateMicros(3);
+}
+
+/*!
+ *    @brief  Runs run() for Adafruit_AW9523::update()
+ *    @param  now Current micros()
+ */
+void Adafruit_AW9523_Blinker::taskRun(uint32_t now) {
+  (void)now;
+  run();
+}
@@ -0,0 +1,52 @@
+/*!
+ *  @file Adafruit_AW9523_Blinker.h
+ *
+ * 	Phase aligned multi-pin blinking for the Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#ifndef _ADAFRUIT_AW9523_BLINKER_H
+#define _ADAFRUIT_AW9523_BLINKER_H
+
+#include "Adafruit_AW9523.h"
+
+/*!
+ *    @brief  Blinks any number of pins, each with its own period and duty
+ *            cycle. Periods are whole ticks counted from one shared start,
+ *            so pins that change at the same moment change together in one
+ *            output write
+ */
+class Adafruit_AW9523_Blinker : public Adafruit_AW9523_Task {
+public:
+  Adafruit_AW9523_Blinker(Adafruit_AW9523 *aw);
+
+  void begin(uint8_t tickMillis = 10);
+  bool blink(uint8_t pin, uint16_t periodMillis, uint8_t dutyPercent = 50);
+  bool stop(uint8_t pin, bool level = false);
+
+  bool run(void);
+  uint16_t writesPerSecond(void);
+
+  uint32_t taskCost(uint32_t now);
+  void taskRun(uint32_t now);
+
+protected:
+  Adafruit_AW9523 *_aw;       ///< The expander with the blinking pins
+  uint16_t _pins = 0;         ///< Pins that are blinking
+  uint16_t _period[16];       ///< Period of each pin, in ticks
+  uint16_t _onTicks[16];      ///< Ticks each period that the pin is high
+  uint16_t _position[16];     ///< Where each pin is in its period
+  uint8_t _tickMillis = 10;   ///< Tick length
+  uint32_t _ticks = 0;        ///< Ticks since begin()
+  uint32_t _lastTick = 0;     ///< millis() of the latest tick
+  uint32_t _windowStart = 0;  ///< millis() the writes/s window opened
+  uint16_t _windowWrites = 0; ///< Writes in the current window
+  uint16_t _writesPerSec = 0; ///< Writes in the last full window
+};
+
+#endif
@@ -0,0 +1,208 @@
+/*!
+ *  @file Adafruit_AW9523_Buttons.cpp
+ *
+ * 	Button gesture detection for the Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#include "Adafruit_AW9523_Buttons.h"
+
+/*!
+ *    @brief  Instantiates a button handler
+ *    @param  aw The expander the buttons are wired to, already begin()'d
+ */
+Adafruit_AW9523_Buttons::Adafruit_AW9523_Buttons(Adafruit_AW9523 *aw) {
+  _aw = aw;
+  memset(_ticks, 0, sizeof(_ticks));
+}
+
+/*!
+ *    @brief  Makes the button pins inputs and starts from all released
+ *    @param  pins 16-bits of pins with buttons
+ *    @param  activeLow True if a pressed button reads low
+ *    @param  tickMillis Milliseconds between poll() samples
+ *    @return True if the pins were set up
+ */
+bool Adafruit_AW9523_Buttons::begin(uint16_t pins, bool activeLow,
+                                    uint8_t tickMillis) {
+  _pins = pins;
+  _invert = activeLow ? pins : 0;
+  _tickMillis = tickMillis;
+  _cnt0 = _cnt1 = _pressed = _held = _clicked = _doubled = 0;
+  _head = _tail = 0;
+  _dropped = 0;
+  memset(_ticks, 0, sizeof(_ticks));
+  _lastTick = millis() - tickMillis; // first poll() ticks straight away
+
+  for (uint8_t pin = 0; pin < 16; pin++) {
+    if ((pins & (1 << pin)) && !_aw->pinMode(pin, INPUT)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Sets the gesture timings, in ticks
+ *    @param  longTicks Held this long is a long press
+ *    @param  repeatTicks Then repeats this often while still held
+ *    @param  doubleTicks Longest gap between presses of a double click
+ */
+void Adafruit_AW9523_Buttons::setTiming(uint8_t longTicks, uint8_t repeatTicks,
+                                        uint8_t doubleTicks) {
+  _longTicks = longTicks;
+  _repeatTicks = repeatTicks;
+  _doubleTicks = doubleTicks;
+}
+
+/*!
+ *    @brief  Reads the inputs and runs a tick, if a tick is due
+ *    @return True if a tick was run
+ */
+bool Adafruit_AW9523_Buttons::poll(void) {
+  uint32_t ms = millis();
+  if (ms - _lastTick < _tickMillis) {
+    return false;
+  }
+  _lastTick = ms;
+  tick(_aw->inputGPIO());
+  return true;
+}
+
+/*!
+ *    @brief  Runs one tick on an input snapshot. Use this instead of poll()
+ *            to feed snapshots taken elsewhere, e.g. in an onChange()
+ *            callback, but keep calling it at a steady rate
+ *    @param  inputs 16-bits of input values as read from the chip
+ */
+void Adafruit_AW9523_Buttons::tick(uint16_t inputs) {
+  uint16_t raw = (inputs ^ _invert) & _pins;
+
+  // two bit vertical counters, a pin changes after 4 samples in a row
+  uint16_t delta = raw ^ _pressed;
+  _cnt1 = (_cnt1 ^ _cnt0) & delta;
+  _cnt0 = ~_cnt0 & delta;
+  uint16_t toggled = delta & ~(_cnt0 | _cnt1);
+  _pressed ^= toggled;
+
+  uint16_t down = toggled & _pressed;
+  uint16_t up = toggled & ~_pressed;
+  uint16_t doubles = down & _clicked;
+  uint16_t clicks = up & ~_held & ~_doubled;
+
+  // only pins with something going on need their counter looked at
+  uint16_t active = _pressed | _clicked | toggled;
+  for (uint8_t pin = 0; active; pin++, active >>= 1) {
+    if (!(active & 1)) {
+      continue;
+    }
+    uint16_t bit = 1 << pin;
+
+    if (toggled & bit) {
+      _ticks[pin] = 0;
+      if (down & bit) {
+        push(pin, AW9523_BUTTON_PRESS);
+        if (doubles & bit) {
+          push(pin, AW9523_BUTTON_DOUBLE_CLICK);
+        }
+      } else {
+        push(pin, AW9523_BUTTON_RELEASE);
+      }
+      continue;
+    }
+
+    if (_ticks[pin] != 0xFF) {
+      _ticks[pin]++;
+    }
+    if (_pressed & bit) {
+      if (!(_held & bit) && (_ticks[pin] >= _longTicks)) {
+        push(pin, AW9523_BUTTON_LONG_PRESS);
+        _held |= bit;
+        _ticks[pin] = 0;
+      } else if ((_held & bit) && _repeatTicks &&
+                 (_ticks[pin] >= _repeatTicks)) {
+        push(pin, AW9523_BUTTON_REPEAT);
+        _ticks[pin] = 0;
+      }
+    } else if ((_clicked & bit) && (_ticks[pin] >= _doubleTicks)) {
+      push(pin, AW9523_BUTTON_CLICK);
+      _clicked &= ~bit;
+    }
+  }
+
+  // a second press ends the wait, a short release starts one
+  _clicked = (_clicked & ~doubles) | clicks;
+  // long press and double click state lasts until the button comes up
+  _held &= _pressed;
+  _doubled = (_doubled | doubles) & _pressed;
+}
+
+/*!
+ *    @brief  Takes the oldest event off the queue
+ *    @param  event Where to put the event
+ *    @return True if there was an event
+ */
+bool Adafruit_AW9523_Buttons::read(aw9523_button_event_t *event) {
+  if (_head == _tail) {
+    return false;
+  }
+  uint8_t e = _queue[_head];
+  _head = (_head + 1) & (AW9523_BUTTON_QUEUE - 1);
+  event->pin = e & 0xF;
+  event->type = e >> 4;
+  return true;
+}
+
+/*!
+ *    @brief  Gets the debounced button states
+ *    @return 16-bits of buttons, 1 == pressed
+ */
+uint16_t Adafruit_AW9523_Buttons::pressed(void) { return _pressed; }
+
+/*!
+ *    @brief  Number of events lost because the queue was full
+ *    @return Events dropped since begin()
+ */
+uint16_t Adafruit_AW9523_Buttons::dropped(void) { return _dropped; }
+
+/*!
+ *    @brief  Estimates the bus cost of poll() if a tick is due
+ *    @param  now Current micros()
+ *    @return Estimated microseconds, or 0 if no tick is due
+ */
+uint32_t Adafruit_AW9523_Buttons::taskCost(uint32_t now) {
+  (void)now;
+  if (millis() - _lastTick < _tickMillis) {
+    return 0;
+  }
+  return _aw->estimateMicros(1, 2);
+}
+
+/*!
+ *    @brief  Runs poll() for Adafruit_AW9523::update()
+ *    @param  now Current micros()
+ */
+void Adafruit_AW9523_Buttons::taskRun(uint32_t now) {
+  (void)now;
+  poll();
+}
+
+/*!
+ *    @brief  Adds an event to the queue, dropping it if the queue is full
+ *    @param  pin GPIO of the button
+ *    @param  type An aw9523_button_event_type_t
+ */
+void Adafruit_AW9523_Buttons::push(uint8_t pin, uint8_t type) {
+  uint8_t next = (_tail + 1) & (AW9523_BUTTON_QUEUE - 1);
+  if (next == _head) {
+    _dropped++;
+    return;
+  }
+  _queue[_tail] = (type << 4) | pin;
+  _tail = next;
+}
@@ -0,0 +1,88 @@
+/*!
+ *  @file Adafruit_AW9523_Buttons.h
+ *
+ * 	Button gesture detection for the Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#ifndef _ADAFRUIT_AW9523_BUTTONS_H
+#define _ADAFRUIT_AW9523_BUTTONS_H
+
+#include "Adafruit_AW9523.h"
+
+#define AW9523_BUTTON_QUEUE 16 ///< Events held until read(), power of two
+
+/*!
+ *    @brief  Kinds of button event
+ */
+typedef enum {
+  AW9523_BUTTON_PRESS,        ///< Went down
+  AW9523_BUTTON_RELEASE,      ///< Came up
+  AW9523_BUTTON_CLICK,        ///< Short press with no second press following
+  AW9523_BUTTON_DOUBLE_CLICK, ///< Two short presses close together
+  AW9523_BUTTON_LONG_PRESS,   ///< Held down for the long press time
+  AW9523_BUTTON_REPEAT,       ///< Still held, repeating after a long press
+} aw9523_button_event_type_t;
+
+/*!
+ *    @brief  One button event
+ */
+typedef struct {
+  uint8_t pin;  ///< GPIO the button is on, from 0 to 15
+  uint8_t type; ///< An aw9523_button_event_type_t
+} aw9523_button_event_t;
+
+/*!
+ *    @brief  Debounces up to 16 buttons and turns them into press, release,
+ *            click, double click, long press and repeat events. All pins are
+ *            handled together as bitmasks with one small tick counter each,
+ *            so 16 buttons cost about the same as one
+ */
+class Adafruit_AW9523_Buttons : public Adafruit_AW9523_Task {
+public:
+  Adafruit_AW9523_Buttons(Adafruit_AW9523 *aw);
+
+  bool begin(uint16_t pins, bool activeLow = true, uint8_t tickMillis = 10);
+  void setTiming(uint8_t longTicks, uint8_t repeatTicks, uint8_t doubleTicks);
+
+  bool poll(void);
+  void tick(uint16_t inputs);
+  bool read(aw9523_button_event_t *event);
+  uint16_t pressed(void);
+  uint16_t dropped(void);
+
+  uint32_t taskCost(uint32_t now);
+  void taskRun(uint32_t now);
+
+protected:
+  void push(uint8_t pin, uint8_t type);
+
+  Adafruit_AW9523 *_aw;      ///< The expander the buttons are on
+  uint16_t _pins = 0;        ///< Pins with buttons
+  uint16_t _invert = 0;      ///< Pins that read low when pressed
+  uint16_t _cnt0 = 0;        ///< Vertical debounce counter, bit 0
+  uint16_t _cnt1 = 0;        ///< Vertical debounce counter, bit 1
+  uint16_t _pressed = 0;     ///< Debounced state, 1 == pressed
+  uint16_t _held = 0;        ///< Long press fired for this press
+  uint16_t _clicked = 0;     ///< Released once, waiting to see if a second
+                             ///< press makes it a double click
+  uint16_t _doubled = 0;     ///< This press was a double click
+  uint8_t _ticks[16];        ///< Ticks since the pin's last event
+  uint8_t _tickMillis = 10;  ///< Tick length
+  uint8_t _longTicks = 50;   ///< Ticks held before a long press
+  uint8_t _repeatTicks = 10; ///< Ticks between repeats
+  uint8_t _doubleTicks = 25; ///< Longest gap between double click presses
+  uint32_t _lastTick = 0;    ///< millis() of the last poll()
+
+  uint8_t _queue[AW9523_BUTTON_QUEUE]; ///< Events, type << 4 | pin
+  uint8_t _head = 0;                   ///< Next event to read
+  uint8_t _tail = 0;                   ///< Next free slot
+  uint16_t _dropped = 0;               ///< Events lost to a full queue
+};
+
+#endif
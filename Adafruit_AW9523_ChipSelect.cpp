@@ -0,0 +1,116 @@
+/*!
+ *  @file Adafruit_AW9523_ChipSelect.cpp
+ *
+ * 	SPI chip select manager for the Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#include "Adafruit_AW9523_ChipSelect.h"
+
+/*!
+ *    @brief  Instantiates a chip select manager
+ *    @param  aw The expander the CS lines are wired to, already begin()'d
+ */
+Adafruit_AW9523_ChipSelect::Adafruit_AW9523_ChipSelect(Adafruit_AW9523 *aw) {
+  _aw = aw;
+}
+
+/*!
+ *    @brief  Makes the CS lines outputs and deselects them all
+ *    @param  csPins 16-bits of pins used as chip selects
+ *    @param  activeHigh True if the devices select on a high level
+ *    @return True if the pins were set up
+ */
+bool Adafruit_AW9523_ChipSelect::begin(uint16_t csPins, bool activeHigh) {
+  _pins = csPins;
+  _activeHigh = activeHigh;
+  _selected = false;
+
+  // idle level first, so no device sees a glitch when it becomes an output
+  if (!_aw->outputGPIOMasked(activeHigh ? 0 : 0xFFFF, csPins)) {
+    return false;
+  }
+  for (uint8_t pin = 0; pin < 16; pin++) {
+    if ((csPins & (1 << pin)) && !_aw->pinMode(pin, OUTPUT)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Selects one device, deselecting any other first. Other pins on
+ *            the same port must not be changed until deselect(), as its
+ *            write is worked out here
+ *    @param  pin CS pin of the device, from 0 to 15 inclusive
+ *    @return True I2C write command was acknowledged
+ */
+bool Adafruit_AW9523_ChipSelect::select(uint8_t pin) {
+  if (!(_pins & (1 << pin))) {
+    return false;
+  }
+  if (_selected && !deselect()) {
+    return false;
+  }
+
+  uint32_t start = micros();
+  uint8_t port = pin >> 3;
+  uint8_t bit = 1 << (pin & 7);
+  uint8_t idle = (uint8_t)(_aw->outputs() >> (port * 8));
+  uint8_t active = _activeHigh ? (idle | bit) : (idle & ~bit);
+
+  bool ok = _aw->outputPort(port, active);
+
+  // the deselect is the same write with the bit flipped back
+  _deselectPort = port;
+  _deselectValue = idle;
+  _selected = ok;
+
+  uint32_t took = micros() - start;
+  _stats.selectTotal += took;
+  if (took > _stats.selectMax) {
+    _stats.selectMax = took;
+  }
+  return ok;
+}
+
+/*!
+ *    @brief  Deselects the device picked by select(), with the write that
+ *            select() prepared
+ *    @return True I2C write command was acknowledged
+ */
+bool Adafruit_AW9523_ChipSelect::deselect(void) {
+  if (!_selected) {
+    return true;
+  }
+
+  uint32_t start = micros();
+  bool ok = _aw->outputPort(_deselectPort, _deselectValue);
+  _selected = !ok;
+
+  uint32_t took = micros() - start;
+  _stats.count++;
+  _stats.deselectTotal += took;
+  if (took > _stats.deselectMax) {
+    _stats.deselectMax = took;
+  }
+  return ok;
+}
+
+/*!
+ *    @brief  Gets the time the CS writes have added to SPI transactions
+ *    @return A copy of the timings
+ */
+aw9523_cs_stats_t Adafruit_AW9523_ChipSelect::stats(void) { return _stats; }
+
+/*!
+ *    @brief  Zeroes the CS timings
+ */
+void Adafruit_AW9523_ChipSelect::clearStats(void) {
+  memset(&_stats, 0, sizeof(_stats));
+}
@@ -0,0 +1,56 @@
+/*!
+ *  @file Adafruit_AW9523_ChipSelect.h
+ *
+ * 	SPI chip select manager for the Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#ifndef _ADAFRUIT_AW9523_CHIPSELECT_H
+#define _ADAFRUIT_AW9523_CHIPSELECT_H
+
+#include "Adafruit_AW9523.h"
+
+/*!
+ *    @brief  Time spent on the expander writes that frame SPI transactions
+ */
+typedef struct {
+  uint32_t count;        ///< Number of select/deselect pairs
+  uint32_t selectMax;    ///< Slowest select(), us
+  uint32_t selectTotal;  ///< Sum of select() times, us
+  uint32_t deselectMax;  ///< Slowest deselect(), us
+  uint32_t deselectTotal; ///< Sum of deselect() times, us
+} aw9523_cs_stats_t;
+
+/*!
+ *    @brief  Drives SPI chip select lines on AW9523 pins. Every select or
+ *            deselect is one single-port write worked out from the driver's
+ *            copy of the outputs, with no reads, and the deselect write is
+ *            prepared while the SPI transaction runs
+ */
+class Adafruit_AW9523_ChipSelect {
+public:
+  Adafruit_AW9523_ChipSelect(Adafruit_AW9523 *aw);
+
+  bool begin(uint16_t csPins, bool activeHigh = false);
+  bool select(uint8_t pin);
+  bool deselect(void);
+
+  aw9523_cs_stats_t stats(void);
+  void clearStats(void);
+
+protected:
+  Adafruit_AW9523 *_aw;             ///< The expander with the CS lines
+  uint16_t _pins = 0;               ///< CS lines
+  bool _activeHigh = false;         ///< CS polarity
+  bool _selected = false;           ///< A device is selected
+  uint8_t _deselectPort = 0;        ///< Port of the selected CS line
+  uint8_t _deselectValue = 0;       ///< Prepared port value to deselect
+  aw9523_cs_stats_t _stats = {0, 0, 0, 0, 0}; ///< Added latency
+};
+
+#endif
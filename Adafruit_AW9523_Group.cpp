@@ -0,0 +1,781 @@
+/*!
+ *  @file Adafruit_AW9523_Group.cpp
+ *
+ * 	Multi-chip manager for the Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#include "Adafruit_AW9523_Group.h"
+#include "Adafruit_AW9523_Trace.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*!
+ *    @brief  Instantiates an empty group
+ */
+Adafruit_AW9523_Group::Adafruit_AW9523_Group(void) {
+  memset(_chips, 0, sizeof(_chips));
+  memset(_chipMux, -1, sizeof(_chipMux));
+  memset(_chipChannel, 0, sizeof(_chipChannel));
+  memset(_mux, 0, sizeof(_mux));
+  memset(_muxWire, 0, sizeof(_muxWire));
+  memset(_muxChannel, AW9523_MUX_UNKNOWN, sizeof(_muxChannel));
+  memset(_output, 0, sizeof(_output));
+  memset(_outputWritten, 0, sizeof(_outputWritten));
+  memset(_outputStaged, 0, sizeof(_outputStaged));
+  memset(_outputRetry, 0, sizeof(_outputRetry));
+  memset(_config, 0, sizeof(_config));
+  memset(_configWritten, 0, sizeof(_configWritten));
+#ifdef AW9523_GROUP_DIMMING
+  memset(_dim, 0, sizeof(_dim));
+  memset(_dimWritten, 0, sizeof(_dimWritten));
+#endif
+  memset(_input, 0, sizeof(_input));
+  memset(_inputBefore, 0, sizeof(_inputBefore));
+  memset(_initMicros, 0, sizeof(_initMicros));
+}
+
+/*!
+ *    @brief  Adds a TCA9548A style I2C mux that some chips sit behind
+ *    @param  address I2C address of the mux
+ *    @param  wire The Wire object the mux is on
+ *    @return Mux number to pass to add(), or -1 if there is no room
+ */
+int8_t Adafruit_AW9523_Group::addMux(uint8_t address, TwoWire *wire) {
+  if (_muxCount >= AW9523_GROUP_MUXES) {
+    return -1;
+  }
+  _mux[_muxCount] = new Adafruit_I2CDevice(address, wire);
+  _muxWire[_muxCount] = wire;
+  _muxChannel[_muxCount] = AW9523_MUX_UNKNOWN;
+  return _muxCount++;
+}
+
+/*!
+ *    @brief  Adds a chip to the group. Chips are flushed in the order they
+ *            are added, so add chips on the same bus next to each other.
+ *            Chips behind a mux are flushed a channel at a time. Either
+ *            add the chips and start them all with the group's begin(), or
+ *            start each with its own begin(). A chip not behind a mux can
+ *            be begun before it is added. A chip behind a mux must be added
+ *            first, then its channel opened with route(), then begun, as
+ *            route() takes the index the chip gets here. The group assumes
+ *            the chip is as begin() left it, all inputs with the dimming
+ *            registers at zero
+ *    @param  aw The chip
+ *    @param  mux Mux number from addMux(), or -1 if not behind a mux
+ *    @param  channel Mux channel the chip is on, from 0 to 7
+ *    @return True if there was room for it
+ */
+bool Adafruit_AW9523_Group::add(Adafruit_AW9523 *aw, int8_t mux,
+                                uint8_t channel) {
+  if ((_count >= AW9523_GROUP_MAX) || (mux >= (int8_t)_muxCount) ||
+      (channel > 7)) {
+    return false;
+  }
+  uint16_t i = _count;
+  _chips[i] = aw;
+  _chipMux[i] = mux;
+  _chipChannel[i] = channel;
+  _output[i * 2] = _outputWritten[i * 2] = (uint8_t)aw->outputs();
+  _output[i * 2 + 1] = _outputWritten[i * 2 + 1] =
+      (uint8_t)(aw->outputs() >> 8);
+  _outputStaged[i >> 3] &= ~(1 << (i & 7));
+  _outputRetry[i >> 3] &= ~(1 << (i & 7));
+  _config[i * 2] = _configWritten[i * 2] = 0xFF;
+  _config[i * 2 + 1] = _configWritten[i * 2 + 1] = 0xFF;
+  _count++;
+  return true;
+}
+
+/*!
+ *    @brief  Starts every chip in the group, doing what each chip's own
+ *            begin() does but a stage at a time across all chips: soft
+ *            resets for all, then ID checks, then configuration. There is
+ *            no waiting on any one chip, writes are chained like flush(),
+ *            and the settings known after a reset are written without
+ *            reading them first. Chips that do not answer or have the wrong
+ *            ID are left out of later stages and report healthy() false.
+ *            Chips begun on a bit-banged bus before stay on that bus
+ *    @param  addresses I2C address of each chip, in the order they were
+ *            added
+ *    @param  wire The Wire object chips not behind a mux are on
+ *    @return Number of chips started
+ */
+uint16_t Adafruit_AW9523_Group::begin(const uint8_t *addresses,
+                                      TwoWire *wire) {
+  AW9523_TRACE_SPAN("begin", NULL);
+  uint32_t start = micros();
+  uint16_t all[AW9523_GROUP_MAX];
+  uint16_t order[AW9523_GROUP_MAX];
+  uint8_t buffer[AW9523_GROUP_MAX * 4];
+
+  for (uint16_t i = 0; i < _count; i++) {
+    int8_t mux = _chipMux[i];
+    if (_chips[i]->_soft) {
+      _chips[i]->_address = addresses[i]; // stays on its bit-banged bus
+    } else {
+      _chips[i]->attach(addresses[i], (mux < 0) ? wire : _muxWire[mux],
+                        false);
+    }
+    _chips[i]->clearBusError();
+    _chips[i]->_healthy = true;
+    _initMicros[i] = 0;
+    all[i] = i;
+  }
+  uint16_t n = muxOrder(all, _count, order);
+
+  // soft reset
+  memset(buffer, 0, _count);
+  writeChain(order, n, AW9523_REG_SOFTRESET, buffer, NULL, 1);
+
+  // check IDs and pick up the output defaults, which depend on the AD pins
+  uint16_t up = 0;
+  n = muxOrder(all, n, order);
+  for (uint16_t k = 0; k < n; k++) {
+    uint16_t i = order[k];
+    Adafruit_AW9523 *aw = _chips[i];
+    uint8_t id;
+    if (route(i) && !aw->busError() && aw->readField<AW9523_CHIPID>(&id) &&
+        (id == 0x23) && aw->readRegister16<AW9523_OUTPUT>(&aw->_outputs)) {
+      all[up++] = i;
+    } else {
+      aw->_healthy = false;
+    }
+  }
+
+  // all inputs, no interrupts: CONFIG0/1 and INTENABLE0/1 in one burst
+  n = muxOrder(all, up, order);
+  memset(buffer, 0xFF, _count * 4);
+  writeChain(order, n, AW9523_REG_CONFIG0, buffer, NULL, 4);
+
+  // push pull port 0, ISEL left at its reset value
+  n = muxOrder(all, up, order);
+  up = 0;
+  for (uint16_t k = 0; k < n; k++) {
+    uint16_t i = order[k];
+    Adafruit_AW9523 *aw = _chips[i];
+    uint8_t gcr = AW9523_GCR_GPOMD::mask;
+    if (!route(i) || aw->busError() ||
+        !aw->writeRegisters(AW9523_GCR_GPOMD::reg, &gcr, 1,
+                            chainEnds(order, k, n))) {
+      aw->_healthy = false;
+      continue;
+    }
+    aw->_intEnabled = 0;
+    _initMicros[i] = micros() - start;
+    up++;
+  }
+
+  for (uint16_t i = 0; i < _count; i++) {
+    uint16_t outputs = _chips[i]->outputs();
+    _output[i * 2] = _outputWritten[i * 2] = (uint8_t)outputs;
+    _output[i * 2 + 1] = _outputWritten[i * 2 + 1] = (uint8_t)(outputs >> 8);
+  }
+  memset(_outputStaged, 0, sizeof(_outputStaged));
+  memset(_outputRetry, 0, sizeof(_outputRetry));
+  memset(_config, 0xFF, _count * 2);
+  memset(_configWritten, 0xFF, _count * 2);
+#ifdef AW9523_GROUP_DIMMING
+  memset(_dim, 0, _count * 16);
+  memset(_dimWritten, 0, _count * 16);
+#endif
+
+  _initTotal = micros() - start;
+  return up;
+}
+
+/*!
+ *    @brief  Time the last begin() took for the whole group
+ *    @return Microseconds
+ */
+uint32_t Adafruit_AW9523_Group::lastInitMicros(void) { return _initTotal; }
+
+/*!
+ *    @brief  Time from the start of the last begin() until one chip was
+ *            ready to use
+ *    @param  index Order the chip was added in, from 0
+ *    @return Microseconds, or 0 if the chip did not start
+ */
+uint32_t Adafruit_AW9523_Group::initMicros(uint16_t index) {
+  return (index < _count) ? _initMicros[index] : 0;
+}
+
+/*!
+ *    @brief  Opens the mux channel a chip is on, if it is not open already.
+ *            Channels on other muxes of the same bus are closed, as chips
+ *            behind different muxes may share an address
+ *    @param  index Order the chip was added in, from 0
+ *    @return True if the chip is reachable
+ */
+bool Adafruit_AW9523_Group::route(uint16_t index) {
+  if ((index >= _count) || (_chipMux[index] < 0)) {
+    return index < _count;
+  }
+  return selectMux(_chipMux[index], _chipChannel[index]);
+}
+
+/*!
+ *    @brief  Number of mux channel writes made, to see how well batching
+ *            by channel is working
+ *    @return Mux writes since the group was made
+ */
+uint32_t Adafruit_AW9523_Group::muxSelects(void) { return _muxSelects; }
+
+/*!
+ *    @brief  Number of chips in the group
+ *    @return Chips added so far
+ */
+uint16_t Adafruit_AW9523_Group::count(void) { return _count; }
+
+/*!
+ *    @brief  Gets one chip of the group
+ *    @param  index Order the chip was added in, from 0
+ *    @return The chip, or NULL if index is out of range
+ */
+Adafruit_AW9523 *Adafruit_AW9523_Group::chip(uint16_t index) {
+  return (index < _count) ? _chips[index] : NULL;
+}
+
+/*!
+ *    @brief  Turns chaining of chips with repeated STARTs on or off. It is
+ *            off by default where the Wire library is known not to support
+ *            it (or AW9523_NO_REPEATED_START is defined), in which case each
+ *            chip gets its own STOP/START
+ *    @param  chained True to hold the bus between chips
+ */
+void Adafruit_AW9523_Group::setChained(bool chained) { _chained = chained; }
+
+/*!
+ *    @brief  Stages a chip's outputs for the next flush(), no bus traffic
+ *    @param  index Order the chip was added in, from 0
+ *    @param  pins 16-bits of binary output settings
+ */
+void Adafruit_AW9523_Group::stageOutputs(uint16_t index, uint16_t pins) {
+  if (index < _count) {
+    _output[index * 2] = (uint8_t)pins;
+    _output[index * 2 + 1] = (uint8_t)(pins >> 8);
+    _outputStaged[index >> 3] |= 1 << (index & 7);
+  }
+}
+
+/*!
+ *    @brief  Stages a chip's pin directions for the next flush()
+ *    @param  index Order the chip was added in, from 0
+ *    @param  pins 16-bits of pin directions, 1 == output, 0 == input
+ */
+void Adafruit_AW9523_Group::stageDirection(uint16_t index, uint16_t pins) {
+  if (index < _count) {
+    _config[index * 2] = (uint8_t)~pins;
+    _config[index * 2 + 1] = (uint8_t)(~pins >> 8);
+  }
+}
+
+#ifdef AW9523_GROUP_DIMMING
+/*!
+ *    @brief  Stages one LED level for the next flush()
+ *    @param  index Order the chip was added in, from 0
+ *    @param  pin GPIO of the LED, from 0 to 15 inclusive
+ *    @param  level Ratio from 0 (off) to 255 (max current)
+ */
+void Adafruit_AW9523_Group::stageLED(uint16_t index, uint8_t pin,
+                                     uint8_t level) {
+  if ((index < _count) && (pin < 16)) {
+    _dim[index * 16 + AW9523_dimRegister(pin) - 0x20] = level;
+  }
+}
+#endif
+
+/*!
+ *    @brief  Writes everything staged that differs from what the chips
+ *            hold: outputs first, then directions, then LED levels. Chips
+ *            not behind a mux go first, then each mux a channel at a time,
+ *            starting with the mux and channel already open. Consecutive
+ *            chips that need no mux switch between them are chained, with
+ *            the STOP only after the last of them
+ *    @return True if every write was acknowledged
+ */
+bool Adafruit_AW9523_Group::flush(void) {
+  AW9523_TRACE_SPAN("flush", NULL);
+  uint32_t start = micros();
+  uint16_t changed[AW9523_GROUP_MAX];
+  uint16_t order[AW9523_GROUP_MAX];
+  bool ok = true;
+  uint16_t n;
+
+  syncOutputs();
+
+  n = changedChips(_output, _outputWritten, _count, 2, changed);
+  n = muxOrder(changed, n, order);
+  ok &= writeChain(order, n, AW9523_REG_OUTPUT0, _output, _outputWritten, 2);
+  unstageWritten();
+
+  n = changedChips(_config, _configWritten, _count, 2, changed);
+  n = muxOrder(changed, n, order);
+  ok &= writeChain(order, n, AW9523_REG_CONFIG0, _config, _configWritten, 2);
+
+#ifdef AW9523_GROUP_DIMMING
+  n = changedChips(_dim, _dimWritten, _count, 16, changed);
+  n = muxOrder(changed, n, order);
+  ok &= writeChain(order, n, 0x20, _dim, _dimWritten, 16);
+#endif
+
+  _flushMicros = micros() - start;
+  return ok;
+}
+
+/*!
+ *    @brief  Time the last flush() took, for comparing chained and unchained
+ *    @return Microseconds
+ */
+uint32_t Adafruit_AW9523_Group::lastFlushMicros(void) { return _flushMicros; }
+
+/*!
+ *    @brief  Changes the outputs of every chip as close to together as the
+ *            bus allows, e.g. for one wide parallel word spread over several
+ *            chips. All payloads are worked out before the first write and
+ *            only the ports that change are sent. Chips are batched by mux
+ *            channel like flush(), so each channel costs one mux write, and
+ *            within a channel the two-port writes go first so the chips
+ *            after the first to change have the shortest transfers
+ *    @param  words Outputs for each chip, in the order they were added
+ *    @return True if every write was acknowledged
+ */
+bool Adafruit_AW9523_Group::writeSynchronized(const uint16_t *words) {
+  AW9523_TRACE_SPAN("writeSynchronized", NULL);
+  uint16_t changed[AW9523_GROUP_MAX];
+  uint16_t order[AW9523_GROUP_MAX];
+  uint8_t ports[AW9523_GROUP_MAX];
+
+  for (uint16_t i = 0; i < _count; i++) {
+    stageOutputs(i, words[i]);
+  }
+  syncOutputs();
+  uint16_t n = changedChips(_output, _outputWritten, _count, 2, changed);
+
+  for (uint16_t c = 0; c < n; c++) {
+    uint16_t i = changed[c];
+    ports[i] = (_output[i * 2] != _outputWritten[i * 2]) |
+               ((_output[i * 2 + 1] != _outputWritten[i * 2 + 1]) << 1);
+  }
+  n = muxOrder(changed, n, order);
+
+  // two-port chips first within each run on one bus and mux channel,
+  // changed is free to use as scratch now
+  for (uint16_t run = 0, end; run < n; run = end) {
+    uint16_t i = order[run];
+    for (end = run + 1; end < n; end++) {
+      uint16_t j = order[end];
+      if ((_chips[j]->bus() != _chips[i]->bus()) ||
+          (_chipMux[j] != _chipMux[i]) ||
+          ((_chipMux[i] >= 0) && (_chipChannel[j] != _chipChannel[i]))) {
+        break;
+      }
+    }
+    uint16_t k = 0;
+    for (uint16_t c = run; c < end; c++) {
+      if (ports[order[c]] == 3) {
+        changed[k++] = order[c];
+      }
+    }
+    for (uint16_t c = run; c < end; c++) {
+      if (ports[order[c]] != 3) {
+        changed[k++] = order[c];
+      }
+    }
+    memcpy(order + run, changed, k * sizeof(order[0]));
+  }
+
+  bool ok = writeChain(order, n, AW9523_REG_OUTPUT0, _output,
+                       _outputWritten, 2, ports);
+  unstageWritten();
+  return ok;
+}
+
+/*!
+ *    @brief  Time from the first chip's output write finishing to the last
+ *            chip's in the last writeSynchronized() or flush(), counting
+ *            only the writes that were acknowledged
+ *    @return Microseconds, 0 if fewer than two chips were written
+ */
+uint32_t Adafruit_AW9523_Group::lastSkewMicros(void) { return _skewMicros; }
+
+/*!
+ *    @brief  Reads the inputs of every chip, a mux channel at a time
+ *    @return Number of chips whose inputs changed since the last read
+ */
+uint16_t Adafruit_AW9523_Group::readInputs(void) {
+  AW9523_TRACE_SPAN("readInputs", NULL);
+  uint16_t all[AW9523_GROUP_MAX];
+  uint16_t order[AW9523_GROUP_MAX];
+
+  memcpy(_inputBefore, _input, _count * 2);
+  for (uint16_t i = 0; i < _count; i++) {
+    all[i] = i;
+  }
+  uint16_t n = muxOrder(all, _count, order);
+  for (uint16_t k = 0; k < n; k++) {
+    uint16_t i = order[k];
+    if (route(i)) {
+      _chips[i]->readRegisters(AW9523_REG_INPUT0, &_input[i * 2], 2);
+    }
+  }
+  return changedChips(_input, _inputBefore, _count, 2, all);
+}
+
+/*!
+ *    @brief  Gets a chip's inputs as of the last readInputs()
+ *    @param  index Order the chip was added in, from 0
+ *    @return 16-bits of binary input (0 == low & 1 == high)
+ */
+uint16_t Adafruit_AW9523_Group::inputs(uint16_t index) {
+  if (index >= _count) {
+    return 0;
+  }
+  return ((uint16_t)_input[index * 2 + 1] << 8) | _input[index * 2];
+}
+
+/*!
+ *    @brief  Lists the chips whose inputs changed in the last readInputs()
+ *    @param  indices Where to put the chip indices, room for count()
+ *    @return Number of chips listed
+ */
+uint16_t Adafruit_AW9523_Group::changedInputs(uint16_t *indices) {
+  return changedChips(_input, _inputBefore, _count, 2, indices);
+}
+
+/*!
+ *    @brief  Lists the chips whose bytes differ between two shadow arrays.
+ *            On hosts with SSE2 or AVX2 this compares 16 or 32 bytes at a
+ *            time and turns the result into a bit mask, so chips with no
+ *            change cost a fraction of a cycle each
+ *    @param  a First shadow, size bytes per chip
+ *    @param  b Second shadow, size bytes per chip
+ *    @param  count Number of chips
+ *    @param  size Bytes per chip, 2 or 16
+ *    @param  indices Where to put the indices of chips that differ
+ *    @return Number of chips listed
+ */
+uint16_t Adafruit_AW9523_Group::changedChips(const uint8_t *a,
+                                             const uint8_t *b, uint16_t count,
+                                             uint8_t size, uint16_t *indices) {
+  uint32_t done = 0;
+  uint16_t n = 0;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+  uint32_t bytes = (uint32_t)count * size;
+  // blocks of 16/32 bytes hold whole chips, as size divides 16
+  while (done < bytes) {
+    uint32_t diff;
+    uint8_t block;
+#if defined(__AVX2__)
+    if (done + 32 <= bytes) {
+      __m256i x = _mm256_loadu_si256((const __m256i *)(a + done));
+      __m256i y = _mm256_loadu_si256((const __m256i *)(b + done));
+      diff = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+      block = 32;
+    } else
+#endif
+        if (done + 16 <= bytes) {
+      __m128i x = _mm_loadu_si128((const __m128i *)(a + done));
+      __m128i y = _mm_loadu_si128((const __m128i *)(b + done));
+      diff = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) & 0xFFFF;
+      block = 16;
+    } else {
+      break;
+    }
+    while (diff) {
+      uint8_t bit = __builtin_ctz(diff);
+      uint16_t chip = (done + bit) / size;
+      indices[n++] = chip;
+      // skip the rest of this chip's bytes
+      uint32_t end = (uint32_t)(chip + 1) * size - done;
+      diff = (end >= 32) ? 0 : diff & ~((1UL << end) - 1);
+    }
+    done += block;
+  }
+#endif
+
+  for (uint16_t chip = done / size; chip < count; chip++) {
+    if (memcmp(a + chip * size, b + chip * size, size)) {
+      indices[n++] = chip;
+    }
+  }
+  return n;
+}
+
+/*!
+ *    @brief  Opens one channel of a mux, closing any channel open on the
+ *            other muxes of the same bus. Does nothing if already open
+ *    @param  mux Mux number from addMux()
+ *    @param  channel Channel to open, from 0 to 7
+ *    @return True if the mux writes were acknowledged
+ */
+bool Adafruit_AW9523_Group::selectMux(uint8_t mux, uint8_t channel) {
+  if (_muxChannel[mux] == channel) {
+    return true;
+  }
+  AW9523_TRACE_SPAN("mux", _muxWire[mux]);
+  bool ok = true;
+  for (uint8_t m = 0; m < _muxCount; m++) {
+    if ((m != mux) && (_muxWire[m] == _muxWire[mux]) &&
+        (_muxChannel[m] != AW9523_MUX_NONE)) {
+      uint8_t none = 0;
+      if (_mux[m]->write(&none, 1)) {
+        _muxChannel[m] = AW9523_MUX_NONE;
+      } else {
+        _muxChannel[m] = AW9523_MUX_UNKNOWN;
+        ok = false;
+      }
+      _muxSelects++;
+    }
+  }
+  if (!ok) {
+    return false; // a channel may still be open onto the same addresses
+  }
+  uint8_t bit = 1 << channel;
+  if (_mux[mux]->write(&bit, 1)) {
+    _muxChannel[mux] = channel;
+  } else {
+    _muxChannel[mux] = AW9523_MUX_UNKNOWN;
+    ok = false;
+  }
+  _muxSelects++;
+  return ok;
+}
+
+/*!
+ *    @brief  Checks whether a chip can be reached without a mux write
+ *    @param  index Order the chip was added in, from 0
+ *    @return True if the chip is not behind a mux or its channel is open
+ */
+bool Adafruit_AW9523_Group::routed(uint16_t index) {
+  int8_t mux = _chipMux[index];
+  return (mux < 0) || (_muxChannel[mux] == _chipChannel[index]);
+}
+
+/*!
+ *    @brief  Puts chips in the order that needs fewest mux writes: chips
+ *            not behind a mux first, then each mux a channel at a time,
+ *            starting with the mux and channel already open
+ *    @param  indices Chips to order
+ *    @param  n Number of chips in indices
+ *    @param  order Where to put the ordered chips
+ *    @return Number of chips in order
+ */
+uint16_t Adafruit_AW9523_Group::muxOrder(const uint16_t *indices, uint16_t n,
+                                         uint16_t *order) {
+  uint16_t k = 0;
+
+  for (uint16_t c = 0; c < n; c++) {
+    if (_chipMux[indices[c]] < 0) {
+      order[k++] = indices[c];
+    }
+  }
+  if (k == n) {
+    return k;
+  }
+
+  // start with whichever mux has a channel open, it costs nothing to use
+  uint8_t firstMux = 0;
+  for (uint8_t m = 0; m < _muxCount; m++) {
+    if (_muxChannel[m] < 8) {
+      firstMux = m;
+    }
+  }
+  for (uint8_t j = 0; j < _muxCount; j++) {
+    uint8_t m = (firstMux + j) % _muxCount;
+    uint8_t open = (_muxChannel[m] < 8) ? _muxChannel[m] : 0;
+    for (uint8_t ch = 0; ch < 8; ch++) {
+      uint8_t channel = (open + ch) & 7;
+      for (uint16_t c = 0; c < n; c++) {
+        uint16_t i = indices[c];
+        if ((_chipMux[i] == (int8_t)m) && (_chipChannel[i] == channel)) {
+          order[k++] = i;
+        }
+      }
+    }
+  }
+  return k;
+}
+
+/*!
+ *    @brief  Checks whether a write in a chain should end with a STOP: it
+ *            is the last, chaining is off, or the next chip is on another
+ *            bus or needs a mux switch first
+ *    @param  order Chips being written, in order
+ *    @param  k Position in order of the chip being written
+ *    @param  n Number of chips in order
+ *    @return True to send a STOP after this chip
+ */
+bool Adafruit_AW9523_Group::chainEnds(const uint16_t *order, uint16_t k,
+                                      uint16_t n) {
+  return !_chained || (k + 1 >= n) ||
+         (_chips[order[k + 1]]->bus() != _chips[order[k]]->bus()) ||
+         !routed(order[k + 1]);
+}
+
+/*!
+ *    @brief  Picks up output writes made straight to the chips, e.g. with
+ *            digitalWrite(). A staged word is still written if the chip no
+ *            longer holds it, and a chip with nothing staged keeps what was
+ *            written to it directly. A chip whose last output write failed
+ *            is written again, whatever its driver thinks it holds
+ */
+void Adafruit_AW9523_Group::syncOutputs(void) {
+  for (uint16_t i = 0; i < _count; i++) {
+    if (_outputRetry[i >> 3] & (1 << (i & 7))) {
+      _outputWritten[i * 2] = ~_output[i * 2];
+      continue;
+    }
+    uint16_t outputs = _chips[i]->outputs();
+    _outputWritten[i * 2] = (uint8_t)outputs;
+    _outputWritten[i * 2 + 1] = (uint8_t)(outputs >> 8);
+    if (!(_outputStaged[i >> 3] & (1 << (i & 7)))) {
+      _output[i * 2] = _outputWritten[i * 2];
+      _output[i * 2 + 1] = _outputWritten[i * 2 + 1];
+    }
+  }
+}
+
+/*!
+ *    @brief  Forgets the staged outputs that have reached their chips, so
+ *            syncOutputs() follows direct writes to those chips again.
+ *            Chips whose write failed stay staged for the next flush
+ */
+void Adafruit_AW9523_Group::unstageWritten(void) {
+  for (uint16_t i = 0; i < _count; i++) {
+    if ((_output[i * 2] == _outputWritten[i * 2]) &&
+        (_output[i * 2 + 1] == _outputWritten[i * 2 + 1])) {
+      _outputStaged[i >> 3] &= ~(1 << (i & 7));
+    }
+  }
+}
+
+/*!
+ *    @brief  Works out which registers of a chip's shadow slice to send
+ *    @param  index Chip in the group
+ *    @param  reg First register of the range
+ *    @param  data Shadow, size bytes per chip
+ *    @param  size Bytes per chip
+ *    @param  ports As for writeChain(), or NULL for the whole range
+ *    @param  start Set to the first register to send
+ *    @param  len Set to the number of registers to send
+ *    @return The first byte to send
+ */
+const uint8_t *Adafruit_AW9523_Group::portSpan(uint16_t index, uint8_t reg,
+                                               const uint8_t *data,
+                                               uint8_t size,
+                                               const uint8_t *ports,
+                                               uint8_t *start, uint8_t *len) {
+  const uint8_t *payload = data + index * size;
+  *start = reg;
+  *len = size;
+  if (ports && (ports[index] == 2)) {
+    payload++;
+    (*start)++;
+    *len = 1;
+  } else if (ports && (ports[index] == 1)) {
+    *len = 1;
+  }
+  return payload;
+}
+
+/*!
+ *    @brief  Writes one register range from a shadow to several chips back
+ *            to back. Mux channels are switched as needed, and chips that
+ *            follow on the same bus with no switch between are chained with
+ *            repeated STARTs. Chips written successfully have the shadow's
+ *            'written' twin brought up to date. Chips whose mux channel
+ *            cannot be opened are skipped and flagged with busError(). With
+ *            verify-after-write on, each chain is read back once it has
+ *            ended. Output writes record the skew for lastSkewMicros()
+ *    @param  order Chips to write, in order
+ *    @param  n Number of chips in order
+ *    @param  reg First register to write
+ *    @param  data Shadow to write from, size bytes per chip
+ *    @param  written Shadow of what the chips hold, updated as they are
+ *            written, or NULL for none
+ *    @param  size Bytes per chip
+ *    @param  ports For 2 byte registers, which ports to send for each chip:
+ *            1 for port 0, 2 for port 1, 3 for both. NULL sends both
+ *    @return True if every write was acknowledged
+ */
+bool Adafruit_AW9523_Group::writeChain(const uint16_t *order, uint16_t n,
+                                       uint8_t reg, const uint8_t *data,
+                                       uint8_t *written, uint8_t size,
+                                       const uint8_t *ports) {
+  bool ok = true, chainOk = true, any = false;
+  uint32_t first = 0, last = 0;
+  uint16_t chain = 0; // where in order the current chain started
+  uint8_t start, len;
+  // a failed output write leaves the chip's shadow holding what was sent,
+  // so remember the chip for syncOutputs()
+  uint8_t *retry = (reg == AW9523_REG_OUTPUT0) ? _outputRetry : NULL;
+
+  for (uint16_t k = 0; k < n; k++) {
+    uint16_t i = order[k];
+    if (!route(i)) {
+      // the write could land on a chip behind another channel, skip it
+      // and leave its shadow stale so the next flush tries again
+      _chips[i]->_busError = true;
+      ok = false;
+      chain = k + 1;
+      continue;
+    }
+    bool stop = chainEnds(order, k, n);
+
+    const uint8_t *payload = portSpan(i, reg, data, size, ports, &start, &len);
+    if (_chips[i]->writeRegisters(start, payload, len, stop)) {
+      if (written) {
+        memcpy(written + i * size, data + i * size, size);
+      }
+      if (retry) {
+        retry[i >> 3] &= ~(1 << (i & 7));
+      }
+      last = micros();
+      if (!any) {
+        first = last;
+        any = true;
+      }
+    } else {
+      ok = chainOk = false;
+      if (retry) {
+        retry[i >> 3] |= 1 << (i & 7);
+      }
+    }
+
+    if (stop) {
+      // the last link verified itself, the rest kept the bus and did not
+      for (uint16_t j = chain; chainOk && (j < k); j++) {
+        uint16_t c = order[j];
+        payload = portSpan(c, reg, data, size, ports, &start, &len);
+        if (!_chips[c]->verifyRegisters(start, payload, len)) {
+          ok = false;
+          if (written) {
+            written[c * size] = ~data[c * size]; // so the next flush retries
+          }
+          if (retry) {
+            retry[c >> 3] |= 1 << (c & 7);
+          }
+        }
+      }
+      chain = k + 1;
+      chainOk = true;
+    }
+  }
+
+  if (reg == AW9523_REG_OUTPUT0) {
+    _skewMicros = last - first;
+  }
+  return ok;
+}
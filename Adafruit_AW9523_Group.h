@@ -0,0 +1,143 @@
+/*!
+ *  @file Adafruit_AW9523_Group.h
+ *
+ * 	Multi-chip manager for the Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#ifndef _ADAFRUIT_AW9523_GROUP_H
+#define _ADAFRUIT_AW9523_GROUP_H
+
+#include "Adafruit_AW9523.h"
+
+// The group's layout depends on AW9523_GROUP_MAX, AW9523_GROUP_MUXES and
+// AW9523_GROUP_NO_DIMMING, so like the other feature macros they must be
+// set as build flags that reach the library too, e.g. with
+// --build-property compiler.cpp.extra_flags=-DAW9523_GROUP_MAX=64. A
+// #define in the sketch only changes the sketch's idea of the group, which
+// then disagrees with the library's and corrupts memory
+#ifndef AW9523_GROUP_MAX
+#define AW9523_GROUP_MAX 16 ///< Most chips in one group, raise on big hosts
+#endif
+#ifndef AW9523_GROUP_MUXES
+#define AW9523_GROUP_MUXES 4 ///< Most TCA9548A style muxes in one group
+#endif
+
+// Dimming shadows take 32 bytes of RAM per chip, too much for small AVRs
+#if !defined(__AVR__) && !defined(AW9523_GROUP_NO_DIMMING)
+#define AW9523_GROUP_DIMMING
+#endif
+
+#define AW9523_MUX_NONE 8       ///< Mux has every channel off
+#define AW9523_MUX_UNKNOWN 0xFF ///< Mux channel not known yet
+
+// Wire libraries known not to hold the bus between devices after
+// endTransmission(false), define this to force the fallback elsewhere
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+#define AW9523_NO_REPEATED_START
+#endif
+
+/*!
+ *    @brief  Manages several AW9523s as one, staging their outputs and
+ *            flushing them together. Chips on the same bus are chained with
+ *            repeated STARTs, so the bus is held for the whole update. Chips
+ *            may sit behind TCA9548A style I2C muxes, to get past the four
+ *            AW9523 addresses; the group keeps track of which channel each
+ *            mux has open and only switches when it has to.
+ *
+ *            Register shadows are kept as structure-of-arrays, one
+ *            contiguous byte array per register across all chips, so
+ *            finding the few chips that need a write is a straight compare
+ *            of two arrays (SSE2/AVX2 on hosts that have it)
+ */
+class Adafruit_AW9523_Group {
+public:
+  Adafruit_AW9523_Group();
+
+  int8_t addMux(uint8_t address = 0x70, TwoWire *wire = &Wire);
+  bool add(Adafruit_AW9523 *aw, int8_t mux = -1, uint8_t channel = 0);
+  uint16_t begin(const uint8_t *addresses, TwoWire *wire = &Wire);
+  uint32_t lastInitMicros(void);
+  uint32_t initMicros(uint16_t index);
+  bool route(uint16_t index);
+  uint32_t muxSelects(void);
+  uint16_t count(void);
+  Adafruit_AW9523 *chip(uint16_t index);
+  void setChained(bool chained);
+
+  void stageOutputs(uint16_t index, uint16_t pins);
+  void stageDirection(uint16_t index, uint16_t pins);
+#ifdef AW9523_GROUP_DIMMING
+  void stageLED(uint16_t index, uint8_t pin, uint8_t level);
+#endif
+  bool flush(void);
+  uint32_t lastFlushMicros(void);
+
+  bool writeSynchronized(const uint16_t *words);
+  uint32_t lastSkewMicros(void);
+
+  uint16_t readInputs(void);
+  uint16_t inputs(uint16_t index);
+  uint16_t changedInputs(uint16_t *indices);
+
+  static uint16_t changedChips(const uint8_t *a, const uint8_t *b,
+                               uint16_t count, uint8_t size,
+                               uint16_t *indices);
+
+protected:
+  bool selectMux(uint8_t mux, uint8_t channel);
+  bool routed(uint16_t index);
+  uint16_t muxOrder(const uint16_t *indices, uint16_t n, uint16_t *order);
+  bool chainEnds(const uint16_t *order, uint16_t k, uint16_t n);
+  void syncOutputs(void);
+  void unstageWritten(void);
+  bool writeChain(const uint16_t *order, uint16_t n, uint8_t reg,
+                  const uint8_t *data, uint8_t *written, uint8_t size,
+                  const uint8_t *ports = NULL);
+  const uint8_t *portSpan(uint16_t index, uint8_t reg, const uint8_t *data,
+                          uint8_t size, const uint8_t *ports, uint8_t *start,
+                          uint8_t *len);
+
+  Adafruit_AW9523 *_chips[AW9523_GROUP_MAX]; ///< Chips in the group
+  int8_t _chipMux[AW9523_GROUP_MAX];         ///< Mux of each chip, -1 none
+  uint8_t _chipChannel[AW9523_GROUP_MAX];    ///< Mux channel of each chip
+  Adafruit_I2CDevice *_mux[AW9523_GROUP_MUXES]; ///< Mux interfaces
+  TwoWire *_muxWire[AW9523_GROUP_MUXES];        ///< Bus of each mux
+  uint8_t _muxChannel[AW9523_GROUP_MUXES];      ///< Open channel of each mux
+  uint8_t _muxCount = 0;                        ///< Muxes added so far
+  uint32_t _muxSelects = 0;                     ///< Mux writes made
+
+  // Shadows, each holds every chip's register bytes back to back
+  uint8_t _output[AW9523_GROUP_MAX * 2];        ///< OUTPUT0/1 wanted
+  uint8_t _outputWritten[AW9523_GROUP_MAX * 2]; ///< OUTPUT0/1 on the chips
+  /// Bit per chip, set while a staged output word waits for a flush
+  uint8_t _outputStaged[(AW9523_GROUP_MAX + 7) / 8];
+  /// Bit per chip, set while its last output write failed or read back wrong
+  uint8_t _outputRetry[(AW9523_GROUP_MAX + 7) / 8];
+  uint8_t _config[AW9523_GROUP_MAX * 2];        ///< CONFIG0/1 wanted
+  uint8_t _configWritten[AW9523_GROUP_MAX * 2]; ///< CONFIG0/1 on the chips
+#ifdef AW9523_GROUP_DIMMING
+  uint8_t _dim[AW9523_GROUP_MAX * 16];        ///< Dimming 0x20-0x2F wanted
+  uint8_t _dimWritten[AW9523_GROUP_MAX * 16]; ///< Dimming on the chips
+#endif
+  uint8_t _input[AW9523_GROUP_MAX * 2];     ///< INPUT0/1, latest read
+  uint8_t _inputBefore[AW9523_GROUP_MAX * 2]; ///< INPUT0/1, read before
+
+  uint16_t _count = 0; ///< Chips added so far
+#ifdef AW9523_NO_REPEATED_START
+  bool _chained = false; ///< Hold the bus between chips
+#else
+  bool _chained = true; ///< Hold the bus between chips
+#endif
+  uint32_t _flushMicros = 0; ///< Time the last flush() took
+  uint32_t _skewMicros = 0;  ///< First to last chip of the last output chain
+  uint32_t _initTotal = 0;   ///< Time the last begin() took
+  uint32_t _initMicros[AW9523_GROUP_MAX]; ///< begin() until each chip ready
+};
+
+#endif
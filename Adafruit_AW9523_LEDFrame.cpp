@@ -0,0 +1,254 @@
+/*!
+ *  @file Adafruit_AW9523_LEDFrame.cpp
+ *
+ * 	Constant current LED frame buffer with adaptive frame rate for the
+ * 	Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#include "Adafruit_AW9523_LEDFrame.h"
+#include "Adafruit_AW9523_Trace.h"
+
+/*!
+ *    @brief  Instantiates an LED frame buffer
+ *    @param  aw The expander the LEDs are on, already begin()'d
+ */
+Adafruit_AW9523_LEDFrame::Adafruit_AW9523_LEDFrame(Adafruit_AW9523 *aw) {
+  _aw = aw;
+  memset(_frame, 0, sizeof(_frame));
+  memset(&_statsAfter, 0, sizeof(_statsAfter));
+}
+
+/*!
+ *    @brief  Puts the LED pins in constant current mode and sets the frame
+ *            rate limits
+ *    @param  pins 16-bits of pins with LEDs
+ *    @param  targetFPS Frame rate to run at when the bus allows
+ *    @param  maxBusPercent Most of the bus time that flushes and the rest
+ *            of the traffic may use together
+ *    @return True if the pins were set up
+ */
+bool Adafruit_AW9523_LEDFrame::begin(uint16_t pins, uint8_t targetFPS,
+                                     uint8_t maxBusPercent) {
+  _targetInterval = _interval = 1000000UL / (targetFPS ? targetFPS : 1);
+  _maxBusPercent = maxBusPercent ? maxBusPercent : 1;
+  _flushAverage = 0;
+  _dropped = 0;
+  _pending = false;
+  _lastFlush = micros() - _interval; // first frame goes straight out
+  _windowStart = millis();
+  _windowFlushes = _fps = 0;
+
+  for (uint8_t pin = 0; pin < 16; pin++) {
+    if ((pins & (1 << pin)) && !_aw->pinMode(pin, AW9523_LED_MODE)) {
+      return false;
+    }
+  }
+  _statsAfter = _aw->stats();
+  _otherMicros = 0;
+  return true;
+}
+
+/*!
+ *    @brief  Sets one LED level in the frame, sent on the next flush
+ *    @param  pin GPIO of the LED, from 0 to 15 inclusive
+ *    @param  value Ratio from 0 (off) to 255 (max current)
+ */
+void Adafruit_AW9523_LEDFrame::setPixel(uint8_t pin, uint8_t value) {
+  _frame[pin & 0xF] = value;
+}
+
+/*!
+ *    @brief  Gets one LED level from the frame
+ *    @param  pin GPIO of the LED, from 0 to 15 inclusive
+ *    @return Ratio from 0 (off) to 255 (max current)
+ */
+uint8_t Adafruit_AW9523_LEDFrame::getPixel(uint8_t pin) {
+  return _frame[pin & 0xF];
+}
+
+/*!
+ *    @brief  Marks the frame as finished. It is flushed by the next run()
+ *            that the frame rate allows; if another frame is shown first the
+ *            two are merged and the earlier one counts as dropped
+ */
+void Adafruit_AW9523_LEDFrame::show(void) {
+  if (_pending) {
+    _dropped++;
+  }
+  _pending = true;
+}
+
+/*!
+ *    @brief  Counts bus time used by other devices on the same bus, so the
+ *            frame rate also backs off for them. Call it with the time each
+ *            transfer to another device took, or an estimate of it
+ *    @param  busMicros Microseconds the bus was busy
+ */
+void Adafruit_AW9523_LEDFrame::reportBusTime(uint32_t busMicros) {
+  _otherMicros += busMicros;
+}
+
+/*!
+ *    @brief  Flushes a shown frame if the current frame interval has passed,
+ *            then adjusts the interval to the measured flush time and the
+ *            share of the bus the rest of the traffic took since the last
+ *            flush
+ *    @return True if a frame was flushed
+ */
+bool Adafruit_AW9523_LEDFrame::run(void) {
+  uint32_t ms = millis();
+  if (ms - _windowStart >= 1000) {
+    _fps = _windowFlushes;
+    _windowFlushes = 0;
+    _windowStart = ms;
+  }
+
+  uint32_t start = micros();
+  if (!_pending || (start - _lastFlush < _interval)) {
+    return false;
+  }
+  AW9523_TRACE_SPAN("frame", NULL);
+  aw9523_stats_t before = _aw->stats();
+  _aw->analogWriteGPIO(_frame);
+  uint32_t took = micros() - start;
+
+  // a blocking bus never makes the flush itself slower, so count what
+  // else used it since the last flush
+  uint32_t other = trafficMicros(_statsAfter, before) + _otherMicros;
+  uint32_t since = start - _lastFlush;
+  uint32_t busy = (other >= since)       ? 100
+                  : (other < 0x1000000UL) ? other * 100 / since
+                                          : other / (since / 100);
+  uint8_t share = (busy < _maxBusPercent) ? _maxBusPercent - busy : 1;
+  _statsAfter = _aw->stats();
+  _otherMicros = 0;
+  _lastFlush = start;
+  _pending = false;
+  _windowFlushes++;
+
+  // smoothed over about 8 flushes, clock stretching shows up as slow ones
+  _flushAverage = _flushAverage ? (_flushAverage * 7 + took) / 8 : took;
+  uint32_t needed = _flushAverage * 100 / share;
+  if (needed < _targetInterval) {
+    needed = _targetInterval;
+  }
+  if (needed > _interval) {
+    _interval = needed; // back off straight away
+  } else {
+    _interval -= (_interval - needed) / 8; // recover gently
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Estimates the bus time of the chip's traffic between two
+ *            stats() snapshots, going by estimateMicros()
+ *    @param  from Earlier snapshot
+ *    @param  to Later snapshot
+ *    @return Microseconds, 0 if the counters were cleared in between
+ */
+uint32_t Adafruit_AW9523_LEDFrame::trafficMicros(const aw9523_stats_t &from,
+                                                 const aw9523_stats_t &to) {
+  if ((to.transfers < from.transfers) ||
+      (to.verifyReads < from.verifyReads) ||
+      (to.bytesWritten < from.bytesWritten) ||
+      (to.bytesRead < from.bytesRead) || (to.verifyBytes < from.verifyBytes)) {
+    return 0;
+  }
+  uint32_t transfers =
+      (to.transfers - from.transfers) + (to.verifyReads - from.verifyReads);
+  uint32_t bytes = (to.bytesWritten - from.bytesWritten) +
+                   (to.bytesRead - from.bytesRead) +
+                   (to.verifyBytes - from.verifyBytes);
+
+  // each transfer's address, START/STOP and overhead, then 9 clocks a
+  // byte, worked out per 10 bytes so slow clocks do not round it away
+  uint32_t transfer = _aw->estimateMicros(0);
+  uint32_t tenBytes = (_aw->estimateMicros(200) - transfer) / 20;
+  return transfers * transfer + bytes * tenBytes / 10;
+}
+
+/*!
+ *    @brief  Frames actually flushed over the last whole second
+ *    @return Frames per second
+ */
+uint16_t Adafruit_AW9523_LEDFrame::fps(void) { return _fps; }
+
+/*!
+ *    @brief  Frames that were merged into a later flush
+ *    @return Frames dropped since begin()
+ */
+uint32_t Adafruit_AW9523_LEDFrame::droppedFrames(void) { return _dropped; }
+
+/*!
+ *    @brief  Frame interval currently in use, at least 1/targetFPS
+ *    @return Microseconds between flushes
+ */
+uint32_t Adafruit_AW9523_LEDFrame::frameInterval(void) { return _interval; }
+
+/*!
+ *    @brief  Prints the frame rates of several frames in OpenMetrics text
+ *            format, to go with Adafruit_AW9523::printMetrics() before the
+ *            closing "# EOF"
+ *    @param  out Where to print, e.g. Serial
+ *    @param  frames The frames, each labelled with its position and the
+ *            address of its chip
+ *    @param  count Number of frames
+ */
+void Adafruit_AW9523_LEDFrame::printMetrics(
+    Print &out, Adafruit_AW9523_LEDFrame *const *frames, uint8_t count) {
+  Adafruit_AW9523::printMetricFamily(out, "aw9523_frame_rate", "gauge",
+                                     "Frames flushed over the last second");
+  for (uint8_t f = 0; f < count; f++) {
+    Adafruit_AW9523::printMetricLabels(out, "aw9523_frame_rate", "", f,
+                                       frames[f]->_aw->address());
+    out.print("} ");
+    out.println(frames[f]->fps());
+  }
+
+  Adafruit_AW9523::printMetricFamily(out, "aw9523_dropped_frames", "counter",
+                                     "Frames merged into a later flush");
+  for (uint8_t f = 0; f < count; f++) {
+    Adafruit_AW9523::printMetricLabels(out, "aw9523_dropped_frames", "_total",
+                                       f, frames[f]->_aw->address());
+    out.print("} ");
+    out.println(frames[f]->droppedFrames());
+  }
+
+  Adafruit_AW9523::printMetricFamily(out, "aw9523_frame_interval_microseconds",
+                                     "gauge", "Frame interval in use");
+  for (uint8_t f = 0; f < count; f++) {
+    Adafruit_AW9523::printMetricLabels(out,
+                                       "aw9523_frame_interval_microseconds",
+                                       "", f, frames[f]->_aw->address());
+    out.print("} ");
+    out.println(frames[f]->frameInterval());
+  }
+}
+
+/*!
+ *    @brief  Estimates the bus cost of run() if a flush is due
+ *    @param  now Current micros()
+ *    @return Estimated microseconds, or 0 if no flush is due
+ */
+uint32_t Adafruit_AW9523_LEDFrame::taskCost(uint32_t now) {
+  if (!_pending || (now - _lastFlush < _interval)) {
+    return 0;
+  }
+  return _aw->estimateMicros(17);
+}
+
+/*!
+ *    @brief  Runs run() for Adafruit_AW9523::update()
+ *    @param  now Current micros()
+ */
+void Adafruit_AW9523_LEDFrame::taskRun(uint32_t now) {
+  (void)now;
+  run();
+}
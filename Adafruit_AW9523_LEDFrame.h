@@ -0,0 +1,69 @@
+/*!
+ *  @file Adafruit_AW9523_LEDFrame.h
+ *
+ * 	Constant current LED frame buffer with adaptive frame rate for the
+ * 	Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#ifndef _ADAFRUIT_AW9523_LEDFRAME_H
+#define _ADAFRUIT_AW9523_LEDFRAME_H
+
+#include "Adafruit_AW9523.h"
+
+/*!
+ *    @brief  Holds one frame of LED levels and flushes it to the chip in a
+ *            single burst. Flush time is measured, and when flushes plus
+ *            the rest of the bus traffic take up more than the allowed
+ *            share of the bus the frame rate is lowered, with frames shown
+ *            in between merged into the next flush. The rest of the traffic
+ *            is the chip's own, from its stats(), and whatever other devices
+ *            report with reportBusTime(). The rate creeps back up as the
+ *            load drops
+ */
+class Adafruit_AW9523_LEDFrame : public Adafruit_AW9523_Task {
+public:
+  Adafruit_AW9523_LEDFrame(Adafruit_AW9523 *aw);
+
+  bool begin(uint16_t pins, uint8_t targetFPS = 60, uint8_t maxBusPercent = 50);
+  void setPixel(uint8_t pin, uint8_t value);
+  uint8_t getPixel(uint8_t pin);
+  void show(void);
+  bool run(void);
+  void reportBusTime(uint32_t busMicros);
+
+  uint16_t fps(void);
+  uint32_t droppedFrames(void);
+  uint32_t frameInterval(void);
+  static void printMetrics(Print &out,
+                           Adafruit_AW9523_LEDFrame *const *frames,
+                           uint8_t count);
+
+  uint32_t taskCost(uint32_t now);
+  void taskRun(uint32_t now);
+
+protected:
+  uint32_t trafficMicros(const aw9523_stats_t &from, const aw9523_stats_t &to);
+
+  Adafruit_AW9523 *_aw;          ///< The expander with the LEDs
+  uint8_t _frame[16];            ///< LED levels by pin
+  bool _pending = false;         ///< show() called since the last flush
+  uint8_t _maxBusPercent = 50;   ///< Most of the bus flushes may take
+  uint32_t _targetInterval = 0;  ///< Frame interval asked for, us
+  uint32_t _interval = 0;        ///< Frame interval in use, us
+  uint32_t _flushAverage = 0;    ///< Smoothed flush time, us
+  uint32_t _lastFlush = 0;       ///< micros() of the last flush
+  aw9523_stats_t _statsAfter;    ///< The chip's stats() after the last flush
+  uint32_t _otherMicros = 0;     ///< reportBusTime() since the last flush
+  uint32_t _dropped = 0;         ///< Frames merged into a later flush
+  uint32_t _windowStart = 0;     ///< millis() the fps window opened
+  uint16_t _windowFlushes = 0;   ///< Flushes in the current window
+  uint16_t _fps = 0;             ///< Flushes in the last full window
+};
+
+#endif
@@ -0,0 +1,129 @@
+/*!
+ *  @file Adafruit_AW9523_Mux.cpp
+ *
+ * 	Analog multiplexer select-line sequencer for the Adafruit AW9523 GPIO
+ * 	expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#include "Adafruit_AW9523_Mux.h"
+
+/*!
+ *    @brief  Instantiates a mux sequencer
+ *    @param  aw The expander the select lines are wired to, already begin()'d
+ */
+Adafruit_AW9523_Mux::Adafruit_AW9523_Mux(Adafruit_AW9523 *aw) { _aw = aw; }
+
+/*!
+ *    @brief  Sets up the select lines as outputs and selects channel 0
+ *    @param  firstPin Expander pin for select bit 0, the other bits follow.
+ *            Keeping them all on one port makes each switch a 1 byte write
+ *    @param  selectBits Number of select lines, from 1 to 4
+ *    @param  analogPin Host analog pin wired to the mux common output
+ *    @param  settleMicros Time the mux output needs after switching
+ *    @return True if the pins were set up
+ */
+bool Adafruit_AW9523_Mux::begin(uint8_t firstPin, uint8_t selectBits,
+                                uint8_t analogPin, uint16_t settleMicros) {
+  if (!selectBits || (selectBits > 4) || (firstPin + selectBits > 16)) {
+    return false;
+  }
+  _firstPin = firstPin;
+  _bits = selectBits;
+  _analogPin = analogPin;
+  _settle = settleMicros;
+  _mask = ((1 << selectBits) - 1) << firstPin;
+
+  for (uint8_t pin = firstPin; pin < firstPin + selectBits; pin++) {
+    if (!_aw->pinMode(pin, OUTPUT)) {
+      return false;
+    }
+  }
+  return select(0);
+}
+
+/*!
+ *    @brief  Splits ADC reads into start and read, so scan() can switch the
+ *            mux to the next channel while the host converts the current
+ *            one. Without this scan() uses analogRead()
+ *    @param  start Starts a conversion on the analog pin, or NULL
+ *    @param  read Waits for and returns the result, or NULL
+ */
+void Adafruit_AW9523_Mux::setConverter(aw9523_adc_start_t start,
+                                       aw9523_adc_read_t read) {
+  _start = start;
+  _read = read;
+}
+
+/*!
+ *    @brief  Switches the mux with one output write and no reads. The
+ *            settle time only restarts if the select lines really changed
+ *    @param  channel Channel to select
+ *    @return True I2C write command was acknowledged
+ */
+bool Adafruit_AW9523_Mux::select(uint8_t channel) {
+  uint16_t before = _aw->outputs() & _mask;
+  bool ok = _aw->outputGPIOMasked((uint16_t)channel << _firstPin, _mask);
+  if ((_aw->outputs() & _mask) != before) {
+    _selectedAt = micros();
+  }
+  return ok;
+}
+
+/*!
+ *    @brief  Number of mux channels
+ *    @return 2 to the power of the number of select lines
+ */
+uint8_t Adafruit_AW9523_Mux::channels(void) { return 1 << _bits; }
+
+/*!
+ *    @brief  Reads every channel, in Gray code order so each switch only
+ *            changes one select line. With setConverter() the next switch
+ *            overlaps the current conversion
+ *    @param  values Where to put the readings, indexed by channel, must hold
+ *            channels() entries
+ *    @return True if every select write was acknowledged
+ */
+bool Adafruit_AW9523_Mux::scan(uint16_t *values) {
+  uint32_t started = micros();
+  uint8_t n = channels();
+  uint8_t channel = grayChannel(0);
+  bool ok = true;
+
+  if (((_aw->outputs() & _mask) >> _firstPin) != channel) {
+    ok = select(channel);
+  }
+
+  for (uint8_t step = 0; step < n; step++) {
+    // after the last channel this wraps to the first, ready for next scan
+    uint8_t next = grayChannel((step + 1) & (n - 1));
+
+    while (micros() - _selectedAt < _settle) {
+      // let the mux output settle
+    }
+
+    if (_start && _read) {
+      _start();
+      ok &= select(next);
+      values[channel] = _read();
+    } else {
+      values[channel] = analogRead(_analogPin);
+      ok &= select(next);
+    }
+    channel = next;
+  }
+
+  _scanMicros = micros() - started;
+  return ok;
+}
+
+/*!
+ *    @brief  Time the last scan() took
+ *    @return Microseconds
+ */
+uint32_t Adafruit_AW9523_Mux::lastScanMicros(void) { return _scanMicros; }
@@ -0,0 +1,68 @@
+/*!
+ *  @file Adafruit_AW9523_Mux.h
+ *
+ * 	Analog multiplexer select-line sequencer for the Adafruit AW9523 GPIO
+ * 	expander, e.g. for 74HC4051 / 74HC4067 muxes
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#ifndef _ADAFRUIT_AW9523_MUX_H
+#define _ADAFRUIT_AW9523_MUX_H
+
+#include "Adafruit_AW9523.h"
+
+/*!
+ *    @brief  Starts a host ADC conversion. Must return once the input has
+ *            been sampled, the mux is switched while the conversion runs
+ */
+typedef void (*aw9523_adc_start_t)(void);
+
+/*!
+ *    @brief  Waits for the conversion started by aw9523_adc_start_t
+ *    @return The converted value
+ */
+typedef uint16_t (*aw9523_adc_read_t)(void);
+
+/*!
+ *    @brief  Drives the select lines of an analog mux from consecutive
+ *            AW9523 pins and scans its channels through a host ADC pin
+ */
+class Adafruit_AW9523_Mux {
+public:
+  Adafruit_AW9523_Mux(Adafruit_AW9523 *aw);
+
+  bool begin(uint8_t firstPin, uint8_t selectBits, uint8_t analogPin,
+             uint16_t settleMicros = 10);
+  void setConverter(aw9523_adc_start_t start, aw9523_adc_read_t read);
+
+  bool select(uint8_t channel);
+  uint8_t channels(void);
+  bool scan(uint16_t *values);
+  uint32_t lastScanMicros(void);
+
+  /*!
+   *    @brief  Gray code scan order, each step changes one select line
+   *    @param  step Position in the scan, from 0
+   *    @return Channel to read at that step
+   */
+  static uint8_t grayChannel(uint8_t step) { return step ^ (step >> 1); }
+
+protected:
+  Adafruit_AW9523 *_aw;               ///< The expander driving the selects
+  aw9523_adc_start_t _start = NULL;   ///< Split ADC start, or NULL
+  aw9523_adc_read_t _read = NULL;     ///< Split ADC read, or NULL
+  uint16_t _settle = 10;              ///< Mux settle time, us
+  uint16_t _mask = 0;                 ///< Select pins
+  uint8_t _firstPin = 0;              ///< Select bit 0
+  uint8_t _bits = 0;                  ///< Number of select lines
+  uint8_t _analogPin = 0;             ///< Host ADC pin on the mux output
+  uint32_t _selectedAt = 0;           ///< micros() of the last switch
+  uint32_t _scanMicros = 0;           ///< Time taken by the last scan()
+};
+
+#endif
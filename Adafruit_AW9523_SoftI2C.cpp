@@ -0,0 +1,323 @@
+/*!
+ *  @file Adafruit_AW9523_SoftI2C.cpp
+ *
+ * 	Bit-banged I2C on any two GPIOs, for the Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#include "Adafruit_AW9523_SoftI2C.h"
+
+/*!
+ *    @brief  Instantiates a bit-banged bus, begin() picks the pins
+ */
+Adafruit_AW9523_SoftI2C::Adafruit_AW9523_SoftI2C(void) {}
+
+/*!
+ *    @brief  Sets up the pins and lets both lines go high
+ *    @param  sda Data pin
+ *    @param  scl Clock pin
+ *    @param  clockHz Bus clock to aim for, see setClock()
+ *    @return True if both lines are high, i.e. the pull-ups are there and
+ *            no device is holding the bus
+ */
+bool Adafruit_AW9523_SoftI2C::begin(uint8_t sda, uint8_t scl,
+                                    uint32_t clockHz) {
+  _sda = sda;
+  _scl = scl;
+  _open = false;
+  setClock(clockHz);
+
+  // output latches low, so switching a pin to output pulls its line low
+  ::pinMode(sda, INPUT);
+  ::pinMode(scl, INPUT);
+  ::digitalWrite(sda, LOW);
+  ::digitalWrite(scl, LOW);
+#ifdef AW9523_SOFTI2C_PORTS
+  _sdaMode = portModeRegister(digitalPinToPort(sda));
+  _sdaIn = portInputRegister(digitalPinToPort(sda));
+  _sdaMask = digitalPinToBitMask(sda);
+  _sclMode = portModeRegister(digitalPinToPort(scl));
+  _sclIn = portInputRegister(digitalPinToPort(scl));
+  _sclMask = digitalPinToBitMask(scl);
+#endif
+  wait();
+  return sdaRead() && sclRead();
+}
+
+/*!
+ *    @brief  Sets the bus clock. The clock comes from delays, so the real
+ *            rate is lower by the time the byte loop takes, most of all
+ *            on slow boards; 0 runs as fast as the CPU allows. Delays come
+ *            in whole microseconds, so any clock above 500 kHz gets the
+ *            shortest one, 1us per half period
+ *    @param  clockHz Bus clock to aim for
+ */
+void Adafruit_AW9523_SoftI2C::setClock(uint32_t clockHz) {
+  if (!clockHz) {
+    _halfPeriod = 0;
+    return;
+  }
+  uint32_t half = 500000UL / clockHz;
+  _halfPeriod = (half < 1) ? 1 : (half > 0xFFFF) ? 0xFFFF : half;
+}
+
+/*!
+ *    @brief  Sets how long a device may hold the clock low before the
+ *            transfer is given up
+ *    @param  micros Longest clock stretch, in microseconds
+ */
+void Adafruit_AW9523_SoftI2C::setStretchTimeout(uint16_t micros) {
+  _stretchLimit = micros;
+}
+
+/*!
+ *    @brief  Writes to a device, prefix first, in one transfer
+ *    @param  address 7-bit I2C address
+ *    @param  buffer Bytes to write
+ *    @param  len Number of bytes in buffer
+ *    @param  stop False to keep the bus for a repeated START afterwards
+ *    @param  prefix Bytes to write before buffer, e.g. a register address
+ *    @param  prefixLen Number of bytes in prefix
+ *    @return True if the device acknowledged every byte
+ */
+bool Adafruit_AW9523_SoftI2C::write(uint8_t address, const uint8_t *buffer,
+                                    size_t len, bool stop,
+                                    const uint8_t *prefix, size_t prefixLen) {
+  bool ok = start() && writeByte(address << 1);
+  for (size_t i = 0; ok && (i < prefixLen); i++) {
+    ok = writeByte(prefix[i]);
+  }
+  for (size_t i = 0; ok && (i < len); i++) {
+    ok = writeByte(buffer[i]);
+  }
+  if (stop || !ok) {
+    this->stop();
+  } else {
+    _open = true;
+  }
+  return ok;
+}
+
+/*!
+ *    @brief  Writes to a device then reads back from it, with a repeated
+ *            START between
+ *    @param  address 7-bit I2C address
+ *    @param  writeBuffer Bytes to write, e.g. a register address
+ *    @param  writeLen Number of bytes to write
+ *    @param  readBuffer Where to put the bytes read
+ *    @param  readLen Number of bytes to read
+ *    @return True if the device acknowledged the write and its address,
+ *            and never held the clock low too long
+ */
+bool Adafruit_AW9523_SoftI2C::writeThenRead(uint8_t address,
+                                            const uint8_t *writeBuffer,
+                                            size_t writeLen,
+                                            uint8_t *readBuffer,
+                                            size_t readLen) {
+  if (!write(address, writeBuffer, writeLen, false)) {
+    return false;
+  }
+  if (!start() || !writeByte((address << 1) | 1)) {
+    stop();
+    return false;
+  }
+  for (size_t i = 0; i < readLen; i++) {
+    if (!readByte(&readBuffer[i], i + 1 < readLen)) {
+      stop();
+      return false;
+    }
+  }
+  stop();
+  return true;
+}
+
+/*!
+ *    @brief  Sends a START, or a repeated START if the bus was kept
+ *    @return True unless the clock was held low too long
+ */
+bool Adafruit_AW9523_SoftI2C::start(void) {
+  if (_open) {
+    // clock is low: let data go high first, then the clock
+    sdaRelease();
+    wait();
+    if (!sclRelease()) {
+      return false;
+    }
+    wait();
+  }
+  _open = false;
+  sdaLow();
+  wait();
+  sclLow();
+  return true;
+}
+
+/*!
+ *    @brief  Sends a STOP, leaving both lines high
+ */
+void Adafruit_AW9523_SoftI2C::stop(void) {
+  sdaLow();
+  wait();
+  sclRelease();
+  wait();
+  sdaRelease();
+  wait();
+  _open = false;
+}
+
+/*!
+ *    @brief  Clocks out one byte, MSB first, and reads the ACK
+ *    @param  value Byte to send
+ *    @return True if the device pulled data low for an ACK
+ */
+bool Adafruit_AW9523_SoftI2C::writeByte(uint8_t value) {
+  for (uint8_t bit = 0x80; bit; bit >>= 1) {
+    if (value & bit) {
+      sdaRelease();
+    } else {
+      sdaLow();
+    }
+    wait();
+    if (!sclRelease()) {
+      return false;
+    }
+    wait();
+    sclLow();
+  }
+
+  sdaRelease();
+  wait();
+  if (!sclRelease()) {
+    return false;
+  }
+  wait();
+  bool ack = !sdaRead();
+  sclLow();
+  return ack;
+}
+
+/*!
+ *    @brief  Clocks in one byte, MSB first, and sends an ACK or a NACK
+ *    @param  value Where to put the byte read
+ *    @param  ack True to ask for more bytes, false after the last one
+ *    @return True unless the clock was held low too long
+ */
+bool Adafruit_AW9523_SoftI2C::readByte(uint8_t *value, bool ack) {
+  *value = 0;
+
+  sdaRelease();
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    wait();
+    if (!sclRelease()) {
+      return false;
+    }
+    wait();
+    *value = (*value << 1) | sdaRead();
+    sclLow();
+  }
+
+  if (ack) {
+    sdaLow();
+  }
+  wait();
+  if (!sclRelease()) {
+    return false;
+  }
+  wait();
+  sclLow();
+  sdaRelease();
+  return true;
+}
+
+/*!
+ *    @brief  Lets the clock go high and waits while a device stretches it
+ *    @return True once the clock is high, false if it stayed low too long
+ */
+bool Adafruit_AW9523_SoftI2C::sclRelease(void) {
+#ifdef AW9523_SOFTI2C_PORTS
+  *_sclMode &= ~_sclMask;
+#else
+  ::pinMode(_scl, INPUT);
+#endif
+  if (sclRead()) {
+    return true;
+  }
+  uint32_t start = micros();
+  while (!sclRead()) {
+    if (micros() - start > _stretchLimit) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Pulls the data line low
+ */
+void Adafruit_AW9523_SoftI2C::sdaLow(void) {
+#ifdef AW9523_SOFTI2C_PORTS
+  *_sdaMode |= _sdaMask;
+#else
+  ::pinMode(_sda, OUTPUT);
+#endif
+}
+
+/*!
+ *    @brief  Lets the data line be pulled high
+ */
+void Adafruit_AW9523_SoftI2C::sdaRelease(void) {
+#ifdef AW9523_SOFTI2C_PORTS
+  *_sdaMode &= ~_sdaMask;
+#else
+  ::pinMode(_sda, INPUT);
+#endif
+}
+
+/*!
+ *    @brief  Pulls the clock line low
+ */
+void Adafruit_AW9523_SoftI2C::sclLow(void) {
+#ifdef AW9523_SOFTI2C_PORTS
+  *_sclMode |= _sclMask;
+#else
+  ::pinMode(_scl, OUTPUT);
+#endif
+}
+
+/*!
+ *    @brief  Reads the data line
+ *    @return True if high
+ */
+bool Adafruit_AW9523_SoftI2C::sdaRead(void) {
+#ifdef AW9523_SOFTI2C_PORTS
+  return *_sdaIn & _sdaMask;
+#else
+  return ::digitalRead(_sda);
+#endif
+}
+
+/*!
+ *    @brief  Reads the clock line
+ *    @return True if high
+ */
+bool Adafruit_AW9523_SoftI2C::sclRead(void) {
+#ifdef AW9523_SOFTI2C_PORTS
+  return *_sclIn & _sclMask;
+#else
+  return ::digitalRead(_scl);
+#endif
+}
+
+/*!
+ *    @brief  Waits half a clock period
+ */
+void Adafruit_AW9523_SoftI2C::wait(void) {
+  if (_halfPeriod) {
+    delayMicroseconds(_halfPeriod);
+  }
+}
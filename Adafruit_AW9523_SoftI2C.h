@@ -0,0 +1,79 @@
+/*!
+ *  @file Adafruit_AW9523_SoftI2C.h
+ *
+ * 	Bit-banged I2C on any two GPIOs, for the Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#ifndef _ADAFRUIT_AW9523_SOFTI2C_H
+#define _ADAFRUIT_AW9523_SOFTI2C_H
+
+#include "Arduino.h"
+
+// Cores where the pins can be driven through their port registers
+#if defined(__AVR__)
+typedef volatile uint8_t aw9523_port_t; ///< Port register of a pin
+#define AW9523_SOFTI2C_PORTS
+#elif defined(ARDUINO_ARCH_SAMD)
+typedef volatile uint32_t aw9523_port_t; ///< Port register of a pin
+#define AW9523_SOFTI2C_PORTS
+#endif
+
+/*!
+ *    @brief  I2C master bit-banged on any two GPIOs, for boards with no
+ *            free I2C peripheral. Needs pull-up resistors on both lines,
+ *            the pins are only ever driven low or let go. Where the core
+ *            allows, the pins are driven through their port registers
+ *            rather than pinMode()/digitalRead(). Whole transfers run in
+ *            one byte loop, and a transfer left open with stop == false is
+ *            followed by a repeated START
+ */
+class Adafruit_AW9523_SoftI2C {
+public:
+  Adafruit_AW9523_SoftI2C();
+
+  bool begin(uint8_t sda, uint8_t scl, uint32_t clockHz = 100000);
+  void setClock(uint32_t clockHz);
+  void setStretchTimeout(uint16_t micros);
+
+  bool write(uint8_t address, const uint8_t *buffer, size_t len,
+             bool stop = true, const uint8_t *prefix = NULL,
+             size_t prefixLen = 0);
+  bool writeThenRead(uint8_t address, const uint8_t *writeBuffer,
+                     size_t writeLen, uint8_t *readBuffer, size_t readLen);
+
+protected:
+  bool start(void);
+  void stop(void);
+  bool writeByte(uint8_t value);
+  bool readByte(uint8_t *value, bool ack);
+  bool sclRelease(void);
+
+  inline void sdaLow(void);
+  inline void sdaRelease(void);
+  inline void sclLow(void);
+  inline bool sdaRead(void);
+  inline bool sclRead(void);
+  inline void wait(void);
+
+  uint8_t _sda = 0;            ///< Data pin
+  uint8_t _scl = 0;            ///< Clock pin
+  uint16_t _halfPeriod = 5;    ///< Microseconds per clock half, 0 == flat out
+  uint16_t _stretchLimit = 1000; ///< Longest clock stretch waited for, us
+  bool _open = false;          ///< Last transfer ended without a STOP
+#ifdef AW9523_SOFTI2C_PORTS
+  aw9523_port_t *_sdaMode = NULL; ///< Direction register of the data pin
+  aw9523_port_t *_sdaIn = NULL;   ///< Input register of the data pin
+  aw9523_port_t *_sclMode = NULL; ///< Direction register of the clock pin
+  aw9523_port_t *_sclIn = NULL;   ///< Input register of the clock pin
+  uint32_t _sdaMask = 0;          ///< Bit of the data pin
+  uint32_t _sclMask = 0;          ///< Bit of the clock pin
+#endif
+};
+
+#endif
@@ -0,0 +1,294 @@
+/*!
+ *  @file Adafruit_AW9523_Steppers.cpp
+ *
+ * 	Unipolar stepper sequencer for the Adafruit AW9523 GPIO expander.
+ * 	Acceleration uses the same step interval recurrence as AccelStepper
+ * 	(D. Austin, "Generate stepper-motor speed profiles in real time")
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#include "Adafruit_AW9523_Steppers.h"
+
+// Coil patterns, bit 0 is the first pin
+static const uint8_t PROGMEM waveSteps[4] = {0x1, 0x2, 0x4, 0x8};
+static const uint8_t PROGMEM fullSteps[4] = {0x3, 0x6, 0xC, 0x9};
+static const uint8_t PROGMEM halfSteps[8] = {0x1, 0x3, 0x2, 0x6,
+                                             0x4, 0xC, 0x8, 0x9};
+
+/*!
+ *    @brief  Instantiates a stepper sequencer
+ *    @param  aw The expander the coils are wired to, already begin()'d
+ */
+Adafruit_AW9523_Steppers::Adafruit_AW9523_Steppers(Adafruit_AW9523 *aw) {
+  _aw = aw;
+  memset(_motors, 0, sizeof(_motors));
+}
+
+/*!
+ *    @brief  Sets up one motor. Its coil pins are made outputs and switched
+ *            off
+ *    @param  motor Motor number, from 0 to 3 inclusive
+ *    @param  firstPin First of four consecutive coil pins, from 0 to 12
+ *    @param  style Coil sequence to use
+ *    @return True if the pins were set up
+ */
+bool Adafruit_AW9523_Steppers::attach(uint8_t motor, uint8_t firstPin,
+                                      aw9523_step_style_t style) {
+  if ((motor >= AW9523_MAX_STEPPERS) || (firstPin > 12)) {
+    return false;
+  }
+  stepper_t *m = &_motors[motor];
+  memset(m, 0, sizeof(*m));
+  m->style = style;
+  m->firstPin = firstPin;
+  m->cmin = 1000; // 1000 steps/s until setSpeed()
+
+  for (uint8_t pin = firstPin; pin < firstPin + 4; pin++) {
+    if (!_aw->pinMode(pin, OUTPUT)) {
+      return false;
+    }
+  }
+  return release(motor);
+}
+
+/*!
+ *    @brief  Sets a motor's speed profile
+ *    @param  motor Motor number, from 0 to 3 inclusive
+ *    @param  maxSpeed Top speed in steps per second
+ *    @param  acceleration Steps per second per second, or 0 to start and
+ *            stop at top speed
+ */
+void Adafruit_AW9523_Steppers::setSpeed(uint8_t motor, float maxSpeed,
+                                        float acceleration) {
+  if ((motor >= AW9523_MAX_STEPPERS) || (maxSpeed <= 0)) {
+    return;
+  }
+  stepper_t *m = &_motors[motor];
+  m->cmin = 1000000.0 / maxSpeed;
+  m->accel = acceleration;
+  // Equation 15 of Austin, with his 0.676 correction for the first step
+  m->c0 = (acceleration > 0) ? 0.676 * sqrt(2.0 / acceleration) * 1000000.0
+                             : m->cmin;
+}
+
+/*!
+ *    @brief  Starts a motor moving to an absolute position
+ *    @param  motor Motor number, from 0 to 3 inclusive
+ *    @param  position Target position in steps
+ */
+void Adafruit_AW9523_Steppers::moveTo(uint8_t motor, int32_t position) {
+  if (motor >= AW9523_MAX_STEPPERS) {
+    return;
+  }
+  stepper_t *m = &_motors[motor];
+  m->target = position;
+  if (!m->interval) {
+    m->lastStep = micros();
+  }
+  computeNewSpeed(m);
+}
+
+/*!
+ *    @brief  Starts a motor moving relative to where it is
+ *    @param  motor Motor number, from 0 to 3 inclusive
+ *    @param  steps Steps to move, negative for backwards
+ */
+void Adafruit_AW9523_Steppers::move(uint8_t motor, int32_t steps) {
+  if (motor < AW9523_MAX_STEPPERS) {
+    moveTo(motor, _motors[motor].position + steps);
+  }
+}
+
+/*!
+ *    @brief  Brings a motor to a stop as fast as its acceleration allows
+ *    @param  motor Motor number, from 0 to 3 inclusive
+ */
+void Adafruit_AW9523_Steppers::stop(uint8_t motor) {
+  if ((motor >= AW9523_MAX_STEPPERS) || !_motors[motor].interval) {
+    return;
+  }
+  stepper_t *m = &_motors[motor];
+  int32_t stepsToStop = 0;
+  if (m->accel > 0) {
+    float speed = 1000000.0 / m->cn;
+    stepsToStop = (int32_t)((speed * speed) / (2.0 * m->accel)) + 1;
+  }
+  moveTo(motor, m->position + (m->forward ? stepsToStop : -stepsToStop));
+}
+
+/*!
+ *    @brief  Turns off all coils of a motor, e.g. to save power when holding
+ *            torque is not needed
+ *    @param  motor Motor number, from 0 to 3 inclusive
+ *    @return True I2C write command was acknowledged
+ */
+bool Adafruit_AW9523_Steppers::release(uint8_t motor) {
+  if (motor >= AW9523_MAX_STEPPERS) {
+    return false;
+  }
+  return _aw->outputGPIOMasked(0, 0xF << _motors[motor].firstPin);
+}
+
+/*!
+ *    @brief  Gets a motor's current position
+ *    @param  motor Motor number, from 0 to 3 inclusive
+ *    @return Position in steps
+ */
+int32_t Adafruit_AW9523_Steppers::position(uint8_t motor) {
+  return (motor < AW9523_MAX_STEPPERS) ? _motors[motor].position : 0;
+}
+
+/*!
+ *    @brief  Checks whether a motor is still moving
+ *    @param  motor Motor number, from 0 to 3 inclusive
+ *    @return True until the motor reaches its target
+ */
+bool Adafruit_AW9523_Steppers::running(uint8_t motor) {
+  return (motor < AW9523_MAX_STEPPERS) && (_motors[motor].interval != 0);
+}
+
+/*!
+ *    @brief  Steps every motor that is due and writes all their coils in one
+ *            output write. Call as often as possible from loop(), or add to
+ *            Adafruit_AW9523::update() with addTask()
+ *    @return True while any motor is moving
+ */
+bool Adafruit_AW9523_Steppers::run(void) {
+  uint32_t now = micros();
+  uint16_t pins = 0, mask = 0;
+  bool moving = false;
+
+  for (uint8_t i = 0; i < AW9523_MAX_STEPPERS; i++) {
+    stepper_t *m = &_motors[i];
+    if (!m->style || !m->interval) {
+      continue;
+    }
+    moving = true;
+    if (now - m->lastStep < m->interval) {
+      continue;
+    }
+    m->lastStep = now;
+    if (m->forward) {
+      m->position++;
+      m->phase++;
+    } else {
+      m->position--;
+      m->phase--;
+    }
+    pins |= (uint16_t)coils(m) << m->firstPin;
+    mask |= 0xF << m->firstPin;
+    computeNewSpeed(m);
+  }
+
+  if (mask) {
+    _aw->outputGPIOMasked(pins, mask);
+  }
+  return moving;
+}
+
+/*!
+ *    @brief  Estimates the bus cost of run() if any motor is due
+ *    @param  now Current micros()
+ *    @return Estimated microseconds, or 0 if no motor is due
+ */
+uint32_t Adafruit_AW9523_Steppers::taskCost(uint32_t now) {
+  for (uint8_t i = 0; i < AW9523_MAX_STEPPERS; i++) {
+    stepper_t *m = &_motors[i];
+    if (m->style && m->interval && (now - m->lastStep >= m->interval)) {
+      return _aw->estimateMicros(3);
+    }
+  }
+  return 0;
+}
+
+/*!
+ *    @brief  Runs one tick for Adafruit_AW9523::update()
+ *    @param  now Current micros()
+ */
+void Adafruit_AW9523_Steppers::taskRun(uint32_t now) {
+  (void)now;
+  run();
+}
+
+/*!
+ *    @brief  Works out the interval to the next step, speeding up, slowing
+ *            down or turning round as needed to reach the target
+ *    @param  m Motor to update
+ */
+void Adafruit_AW9523_Steppers::computeNewSpeed(stepper_t *m) {
+  int32_t distanceTo = m->target - m->position;
+
+  if (m->accel <= 0) {
+    // no ramp, run flat out until we get there
+    m->forward = distanceTo > 0;
+    m->cn = m->cmin;
+    m->interval = distanceTo ? (uint32_t)m->cmin : 0;
+    return;
+  }
+
+  int32_t stepsToStop = 0;
+  if (m->n != 0) {
+    float speed = 1000000.0 / m->cn;
+    stepsToStop = (int32_t)((speed * speed) / (2.0 * m->accel));
+  }
+  if ((distanceTo == 0) && (stepsToStop <= 1)) {
+    m->interval = 0;
+    m->n = 0;
+    return;
+  }
+
+  if (distanceTo > 0) {
+    if (m->n > 0) {
+      if ((stepsToStop >= distanceTo) || !m->forward) {
+        m->n = -stepsToStop; // start slowing down
+      }
+    } else if (m->n < 0) {
+      if ((stepsToStop < distanceTo) && m->forward) {
+        m->n = -m->n; // speed back up
+      }
+    }
+  } else if (distanceTo < 0) {
+    if (m->n > 0) {
+      if ((stepsToStop >= -distanceTo) || m->forward) {
+        m->n = -stepsToStop;
+      }
+    } else if (m->n < 0) {
+      if ((stepsToStop < -distanceTo) && !m->forward) {
+        m->n = -m->n;
+      }
+    }
+  }
+
+  if (m->n == 0) {
+    m->cn = m->c0;
+    m->forward = distanceTo > 0;
+  } else {
+    m->cn = m->cn - ((2.0 * m->cn) / ((4.0 * m->n) + 1));
+    if (m->cn < m->cmin) {
+      m->cn = m->cmin;
+    }
+  }
+  m->n++;
+  m->interval = (uint32_t)m->cn;
+}
+
+/*!
+ *    @brief  Looks up the coil pattern for a motor's current phase
+ *    @param  m Motor to look up
+ *    @return Four bits of coil drive, bit 0 is the first pin
+ */
+uint8_t Adafruit_AW9523_Steppers::coils(stepper_t *m) {
+  switch (m->style) {
+  case AW9523_STEP_WAVE:
+    return pgm_read_byte(&waveSteps[m->phase & 0x3]);
+  case AW9523_STEP_FULL:
+    return pgm_read_byte(&fullSteps[m->phase & 0x3]);
+  default:
+    return pgm_read_byte(&halfSteps[m->phase & 0x7]);
+  }
+}
@@ -0,0 +1,81 @@
+/*!
+ *  @file Adafruit_AW9523_Steppers.h
+ *
+ * 	Unipolar stepper sequencer for the Adafruit AW9523 GPIO expander
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#ifndef _ADAFRUIT_AW9523_STEPPERS_H
+#define _ADAFRUIT_AW9523_STEPPERS_H
+
+#include "Adafruit_AW9523.h"
+
+#define AW9523_MAX_STEPPERS 4 ///< Four coils each, so four fill the chip
+
+/*!
+ *    @brief  Coil sequences for attach()
+ */
+typedef enum {
+  AW9523_STEP_NONE,  ///< Motor not attached
+  AW9523_STEP_WAVE,  ///< One coil at a time, 4 steps
+  AW9523_STEP_FULL,  ///< Two coils at a time, 4 steps, full torque
+  AW9523_STEP_HALF,  ///< Alternating one and two coils, 8 steps
+} aw9523_step_style_t;
+
+/*!
+ *    @brief  Drives up to four unipolar steppers from one AW9523, with
+ *            acceleration. The coils of every motor that steps in a tick go
+ *            out in one output write, so motors stay in lock step
+ */
+class Adafruit_AW9523_Steppers : public Adafruit_AW9523_Task {
+public:
+  Adafruit_AW9523_Steppers(Adafruit_AW9523 *aw);
+
+  bool attach(uint8_t motor, uint8_t firstPin,
+              aw9523_step_style_t style = AW9523_STEP_FULL);
+  void setSpeed(uint8_t motor, float maxSpeed, float acceleration);
+  void moveTo(uint8_t motor, int32_t position);
+  void move(uint8_t motor, int32_t steps);
+  void stop(uint8_t motor);
+  bool release(uint8_t motor);
+  int32_t position(uint8_t motor);
+  bool running(uint8_t motor);
+
+  bool run(void);
+
+  uint32_t taskCost(uint32_t now);
+  void taskRun(uint32_t now);
+
+protected:
+  /*!
+   *    @brief  State for one motor
+   */
+  typedef struct {
+    uint8_t style;     ///< aw9523_step_style_t, NONE if unused
+    uint8_t firstPin;  ///< Coils are on firstPin to firstPin + 3
+    uint8_t phase;     ///< Index into the coil table
+    bool forward;      ///< Direction of travel
+    int32_t position;  ///< Current position in steps
+    int32_t target;    ///< Where we are going
+    int32_t n;         ///< Step in the ramp, negative when slowing down
+    float c0;          ///< First step interval from rest, us
+    float cn;          ///< Current step interval, us
+    float cmin;        ///< Step interval at top speed, us
+    float accel;       ///< Acceleration, steps/s/s, 0 for none
+    uint32_t lastStep; ///< micros() of the last step
+    uint32_t interval; ///< Time to the next step, us, 0 when stopped
+  } stepper_t;
+
+  void computeNewSpeed(stepper_t *m);
+  uint8_t coils(stepper_t *m);
+
+  Adafruit_AW9523 *_aw;                      ///< The expander we drive
+  stepper_t _motors[AW9523_MAX_STEPPERS];    ///< Per-motor state
+};
+
+#endif
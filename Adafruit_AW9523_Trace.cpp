@@ -0,0 +1,128 @@
+/*!
+ *  @file Adafruit_AW9523_Trace.cpp
+ *
+ * 	Timeline tracer for the Adafruit AW9523 GPIO expander library
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#include "Adafruit_AW9523_Trace.h"
+
+#ifdef AW9523_TRACE
+
+uint8_t Adafruit_AW9523_Trace::depth = 0;
+aw9523_trace_span_t Adafruit_AW9523_Trace::_spans[AW9523_TRACE_SPANS];
+uint16_t Adafruit_AW9523_Trace::_next = 0;
+uint16_t Adafruit_AW9523_Trace::_count = 0;
+uint32_t Adafruit_AW9523_Trace::_dropped = 0;
+const void *Adafruit_AW9523_Trace::_buses[AW9523_TRACE_BUSES];
+
+/*!
+ *    @brief  Adds a finished span, overwriting the oldest if full
+ *    @param  name What was being done, a string literal
+ *    @param  bus The Wire object the work was on, or NULL for the host
+ *    @param  start micros() at the start
+ *    @param  duration Microseconds it took
+ *    @param  depth Spans open around it when it started
+ */
+void Adafruit_AW9523_Trace::record(const char *name, const void *bus,
+                                   uint32_t start, uint32_t duration,
+                                   uint8_t depth) {
+  aw9523_trace_span_t *span = &_spans[_next];
+  span->name = name;
+  span->start = start;
+  span->duration = duration;
+  span->track = track(bus);
+  span->depth = depth;
+
+  _next = (_next + 1) % AW9523_TRACE_SPANS;
+  if (_count < AW9523_TRACE_SPANS) {
+    _count++;
+  } else {
+    _dropped++;
+  }
+}
+
+/*!
+ *    @brief  Prints the spans held as Chrome trace-event JSON, oldest
+ *            first, then clears them. Save the output to a .json file and
+ *            open it in Perfetto or chrome://tracing
+ *    @param  out Where to print, e.g. Serial
+ */
+void Adafruit_AW9523_Trace::printJSON(Print &out) {
+  out.print("{\"traceEvents\":[");
+  out.print("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+            "\"args\":{\"name\":\"host\"}}");
+  for (uint8_t b = 0; b < AW9523_TRACE_BUSES; b++) {
+    if (_buses[b]) {
+      out.print(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+      out.print(b + 1);
+      out.print(",\"args\":{\"name\":\"bus ");
+      out.print(b);
+      out.print("\"}}");
+    }
+  }
+
+  uint16_t first = (_next + AW9523_TRACE_SPANS - _count) % AW9523_TRACE_SPANS;
+  for (uint16_t i = 0; i < _count; i++) {
+    const aw9523_trace_span_t *span =
+        &_spans[(first + i) % AW9523_TRACE_SPANS];
+    out.print(",\n{\"name\":\"");
+    out.print(span->name);
+    out.print("\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+    out.print(span->track);
+    out.print(",\"ts\":");
+    out.print(span->start);
+    out.print(",\"dur\":");
+    out.print(span->duration);
+    out.print(",\"args\":{\"depth\":");
+    out.print(span->depth);
+    out.print("}}");
+  }
+
+  out.print("],\"otherData\":{\"dropped\":");
+  out.print(_dropped);
+  out.println("}}");
+  clear();
+}
+
+/*!
+ *    @brief  Forgets all spans held
+ */
+void Adafruit_AW9523_Trace::clear(void) {
+  _next = _count = 0;
+  _dropped = 0;
+}
+
+/*!
+ *    @brief  Spans overwritten before they were printed
+ *    @return Spans lost since the last printJSON() or clear()
+ */
+uint32_t Adafruit_AW9523_Trace::dropped(void) { return _dropped; }
+
+/*!
+ *    @brief  Finds the track for a bus, giving it one if it is new
+ *    @param  bus The Wire object, or NULL for the host
+ *    @return 0 for the host, 1 on for each bus. Buses past
+ *            AW9523_TRACE_BUSES share the last track
+ */
+uint8_t Adafruit_AW9523_Trace::track(const void *bus) {
+  if (!bus) {
+    return 0;
+  }
+  for (uint8_t b = 0; b < AW9523_TRACE_BUSES; b++) {
+    if (!_buses[b]) {
+      _buses[b] = bus;
+    }
+    if (_buses[b] == bus) {
+      return b + 1;
+    }
+  }
+  return AW9523_TRACE_BUSES;
+}
+
+#endif
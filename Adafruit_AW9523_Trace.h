@@ -0,0 +1,108 @@
+/*!
+ *  @file Adafruit_AW9523_Trace.h
+ *
+ * 	Timeline tracer for the Adafruit AW9523 GPIO expander library
+ *
+ * 	Adafruit invests time and resources providing this open source code,
+ *  please support Adafruit and open-source hardware by purchasing products from
+ * 	Adafruit!
+ *
+ *	BSD license (see license.txt)
+ */
+
+#ifndef _ADAFRUIT_AW9523_TRACE_H
+#define _ADAFRUIT_AW9523_TRACE_H
+
+#include "Arduino.h"
+
+#ifdef AW9523_TRACE
+
+#ifndef AW9523_TRACE_SPANS
+#ifdef __AVR__
+#define AW9523_TRACE_SPANS 32 ///< Spans kept, the oldest are overwritten
+#else
+#define AW9523_TRACE_SPANS 256 ///< Spans kept, the oldest are overwritten
+#endif
+#endif
+#define AW9523_TRACE_BUSES 4 ///< Buses given their own track
+
+/*!
+ *    @brief  One finished span
+ */
+typedef struct {
+  const char *name;  ///< What was being done, a string literal
+  uint32_t start;    ///< micros() at the start
+  uint32_t duration; ///< Microseconds it took
+  uint8_t track;     ///< 0 for the host, 1 on for each bus
+  uint8_t depth;     ///< Spans open around it when it started
+} aw9523_trace_span_t;
+
+/*!
+ *    @brief  Records spans of library work in a ring buffer and exports
+ *            them as Chrome trace-event JSON, which Perfetto and
+ *            chrome://tracing load. Bus transfers go on a track per bus,
+ *            higher level work (flushes, frames, servicing) on the host
+ *            track. Only built with AW9523_TRACE defined
+ */
+class Adafruit_AW9523_Trace {
+public:
+  static void record(const char *name, const void *bus, uint32_t start,
+                     uint32_t duration, uint8_t depth);
+  static void printJSON(Print &out);
+  static void clear(void);
+  static uint32_t dropped(void);
+
+  static uint8_t depth; ///< Spans open right now
+
+protected:
+  static uint8_t track(const void *bus);
+
+  static aw9523_trace_span_t _spans[AW9523_TRACE_SPANS]; ///< Ring buffer
+  static uint16_t _next;    ///< Slot the next span goes in
+  static uint16_t _count;   ///< Spans held
+  static uint32_t _dropped; ///< Spans overwritten before being printed
+  static const void *_buses[AW9523_TRACE_BUSES]; ///< Bus of each track
+};
+
+/*!
+ *    @brief  Times the enclosing scope as one span
+ */
+class Adafruit_AW9523_TraceScope {
+public:
+  /*!
+   *    @brief  Opens a span
+   *    @param  name What is being done, a string literal
+   *    @param  bus The Wire object the work is on, or NULL for the host
+   */
+  Adafruit_AW9523_TraceScope(const char *name, const void *bus)
+      : _name(name), _bus(bus), _depth(Adafruit_AW9523_Trace::depth++),
+        _start(micros()) {}
+
+  /*!
+   *    @brief  Closes the span and records it
+   */
+  ~Adafruit_AW9523_TraceScope() {
+    Adafruit_AW9523_Trace::record(_name, _bus, _start, micros() - _start,
+                                  _depth);
+    Adafruit_AW9523_Trace::depth--;
+  }
+
+protected:
+  const char *_name; ///< What is being done
+  const void *_bus;  ///< Bus the work is on
+  uint8_t _depth;    ///< Spans open around this one
+  uint32_t _start;   ///< micros() at the start
+};
+
+/// Times the rest of the enclosing scope as a span
+#define AW9523_TRACE_SPAN(name, bus)                                         \
+  Adafruit_AW9523_TraceScope _aw9523TraceScope(name, bus)
+
+#else
+
+/// Tracing is off, spans cost nothing
+#define AW9523_TRACE_SPAN(name, bus)
+
+#endif
+
+#endif
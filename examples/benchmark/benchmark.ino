@@ -0,0 +1,485 @@
+// Times the public API on real hardware, the driver and the helpers built
+// on it, and prints one CSV line per test, so runs on different boards and
+// bus speeds can be compared:
+//
+//   bench,<name>,<calls>,<us/call>,<ops/s>,<bus bytes/call>
+//
+// Helpers that only write when a tick or step is due are timed over the
+// calls that wrote, so their lines show the cost of a tick. Plain setters
+// and getters that only touch RAM are left out, apart from outputs().
+//
+// The "legacy_" tests do the same job the way the library used to, one
+// Adafruit_I2CRegisterBits read-modify-write per call. A second chip at
+// 0x59 on the same bus adds the group tests.
+//
+// To compare bit-banged I2C with TwoWire, also wire the first chip's SDA
+// and SCL (with their pull-ups) to the two pins below and uncomment them.
+//
+// The last tests time the library's own CPU work with no bus traffic at
+// all, the overhead between bytes that matters on slow boards:
+//
+//   cpu,<name>,<calls>,<ns/call>
+//
+// Built with AW9523_FAULT_INJECTION defined, e.g. with
+// --build-property compiler.cpp.extra_flags=-DAW9523_FAULT_INJECTION, it
+// also sweeps injected fault rates over outputGPIO(), retrying each failed
+// call with a growing back-off, to show how throughput degrades and how
+// many calls the retries win back:
+//
+//   fault,<rate/65535>,<calls>,<us/call>,<ops/s>,<failed>,<recovered>,
+//         <nack>,<arbitration>,<stretch>,<stuck>,<reset>
+#include <Adafruit_AW9523.h>
+#include <Adafruit_AW9523_Blinker.h>
+#include <Adafruit_AW9523_Buttons.h>
+#include <Adafruit_AW9523_ChipSelect.h>
+#include <Adafruit_AW9523_Group.h>
+#include <Adafruit_AW9523_LEDFrame.h>
+#include <Adafruit_AW9523_Mux.h>
+#include <Adafruit_AW9523_SoftI2C.h>
+#include <Adafruit_AW9523_Steppers.h>
+
+#define BUS_HZ 400000   // I2C clock to test at
+#define CALLS 200       // calls per test
+#define CPU_CALLS 5000  // calls per CPU only test
+#define FAULT_RETRIES 5 // retries per call in the fault sweep
+#define DUE_MILLIS 5000 // longest wait for ticks in a due-only test
+#define MUX_ANALOG A0   // host ADC pin for the analog mux test
+// #define SOFT_SDA 4   // bit-banged data pin
+// #define SOFT_SCL 5   // bit-banged clock pin
+
+Adafruit_AW9523 aw;
+Adafruit_AW9523 aw2;
+Adafruit_AW9523 softAw;
+Adafruit_AW9523_SoftI2C softBus;
+Adafruit_AW9523_Group group;
+Adafruit_I2CDevice legacyDev(0x58);
+Adafruit_AW9523_Buttons buttons(&aw);
+Adafruit_AW9523_LEDFrame frame(&aw);
+Adafruit_AW9523_ChipSelect cs(&aw);
+Adafruit_AW9523_Mux mux(&aw);
+Adafruit_AW9523_Blinker blinker(&aw);
+Adafruit_AW9523_Steppers steppers(&aw);
+Adafruit_AW9523 *chips[] = {&aw, &aw2};
+Adafruit_AW9523_Group cpuGroup;
+uint8_t shadowA[AW9523_GROUP_MAX * 2], shadowB[AW9523_GROUP_MAX * 2];
+uint16_t changedList[AW9523_GROUP_MAX];
+uint32_t cpuEmptyNanos = 0;
+
+bool haveSecond = false;
+uint16_t counter = 0;
+
+// prints a bench line, calls and took from the test, bytes from the stats
+void report(const char *name, uint16_t calls, uint32_t took) {
+  aw9523_stats_t s1 = aw.stats(), s2 = aw2.stats(), s3 = softAw.stats();
+  uint32_t bytes = s1.bytesWritten + s1.bytesRead + s1.verifyBytes +
+                   s2.bytesWritten + s2.bytesRead + s2.verifyBytes +
+                   s3.bytesWritten + s3.bytesRead + s3.verifyBytes;
+  if (!calls) {
+    calls = 1; // nothing was due, print zeros rather than divide by 0
+  }
+
+  Serial.print("bench,");
+  Serial.print(name);
+  Serial.print(',');
+  Serial.print(calls);
+  Serial.print(',');
+  Serial.print((float)took / calls, 2);
+  Serial.print(',');
+  Serial.print(took ? (uint32_t)(1000000.0 * calls / took) : 0);
+  Serial.print(',');
+  // legacy tests bypass the driver, so they show 0 here
+  Serial.println((float)bytes / calls, 2);
+}
+
+void clearAllStats() {
+  aw.clearStats();
+  aw2.clearStats();
+  softAw.clearStats();
+}
+
+void bench(const char *name, void (*fn)(void)) {
+  clearAllStats();
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < CALLS; i++) {
+    fn();
+    counter++;
+  }
+  report(name, CALLS, micros() - start);
+}
+
+// for calls that only write when a tick or step is due: keeps calling for
+// up to DUE_MILLIS, timing only the calls that made a transfer
+void benchDue(const char *name, void (*fn)(void)) {
+  clearAllStats();
+  uint16_t calls = 0;
+  uint32_t took = 0;
+  uint32_t started = millis();
+  while ((calls < CALLS) && (millis() - started < DUE_MILLIS)) {
+    uint32_t transfers = aw.stats().transfers;
+    uint32_t start = micros();
+    fn();
+    uint32_t end = micros();
+    if (aw.stats().transfers != transfers) {
+      took += end - start;
+      calls++;
+    }
+    counter++;
+  }
+  report(name, calls, took);
+}
+
+// swallows printMetrics() output so it does not end up in the report
+class NullPrint : public Print {
+public:
+  size_t write(uint8_t c) {
+    (void)c;
+    return 1;
+  }
+} nullPrint;
+
+uint32_t cpuNanos(void (*fn)(void)) {
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < CPU_CALLS; i++) {
+    fn();
+    counter++;
+  }
+  return (uint32_t)((micros() - start) * 1000.0 / CPU_CALLS);
+}
+
+void cpu(const char *name, void (*fn)(void)) {
+  uint32_t ns = cpuNanos(fn);
+
+  Serial.print("cpu,");
+  Serial.print(name);
+  Serial.print(',');
+  Serial.print(CPU_CALLS);
+  Serial.print(',');
+  // less the cost of the loop and call themselves
+  Serial.println(ns > cpuEmptyNanos ? ns - cpuEmptyNanos : 0);
+}
+
+#ifdef AW9523_FAULT_INJECTION
+void faultSweep(uint16_t rate) {
+  // NACKs, arbitration losses and stretches at the rate, the rarer stuck
+  // bus and spontaneous reset at an eighth of it
+  aw9523_fault_rates_t rates = {rate, rate, rate, (uint16_t)(rate / 8),
+                                (uint16_t)(rate / 8), 200, 2000};
+  aw.setFaultRates(rates, 1);
+  uint16_t failed = 0, recovered = 0;
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < CALLS; i++) {
+    uint8_t tries = 0;
+    while (!aw.outputGPIO(counter) && (tries < FAULT_RETRIES)) {
+      delayMicroseconds(100U << tries++); // long enough to outlast stuck
+    }
+    if (tries) {
+      failed++;
+      recovered += aw.outputs() == counter;
+    }
+    counter++;
+  }
+  uint32_t took = micros() - start;
+  aw9523_fault_counts_t faults = aw.faultCounts();
+  aw.clearBusError();
+
+  Serial.print("fault,");
+  Serial.print(rate);
+  Serial.print(',');
+  Serial.print(CALLS);
+  Serial.print(',');
+  Serial.print((float)took / CALLS, 2);
+  Serial.print(',');
+  Serial.print(took ? (uint32_t)(1000000.0 * CALLS / took) : 0);
+  Serial.print(',');
+  Serial.print(failed);
+  Serial.print(',');
+  Serial.print(recovered);
+  Serial.print(',');
+  Serial.print(faults.nack);
+  Serial.print(',');
+  Serial.print(faults.arbitration);
+  Serial.print(',');
+  Serial.print(faults.stretch);
+  Serial.print(',');
+  Serial.print(faults.stuck);
+  Serial.print(',');
+  Serial.println(faults.reset);
+}
+#endif
+
+void legacyDigitalWrite() {
+  Adafruit_I2CRegister output0reg =
+      Adafruit_I2CRegister(&legacyDev, AW9523_REG_OUTPUT0, 2, LSBFIRST);
+  Adafruit_I2CRegisterBits outbit =
+      Adafruit_I2CRegisterBits(&output0reg, 1, 3); // # bits, bit_shift
+  outbit.write(counter & 1);
+}
+
+void legacyDigitalRead() {
+  Adafruit_I2CRegister inputreg =
+      Adafruit_I2CRegister(&legacyDev, AW9523_REG_INPUT0, 2, LSBFIRST);
+  Adafruit_I2CRegisterBits inbit = Adafruit_I2CRegisterBits(&inputreg, 1, 9);
+  inbit.read();
+}
+
+void legacyPinMode() {
+  Adafruit_I2CRegister confreg =
+      Adafruit_I2CRegister(&legacyDev, AW9523_REG_CONFIG0, 2, LSBFIRST);
+  Adafruit_I2CRegister ledmodereg =
+      Adafruit_I2CRegister(&legacyDev, AW9523_REG_LEDMODE0, 2, LSBFIRST);
+  Adafruit_I2CRegisterBits confbit = Adafruit_I2CRegisterBits(&confreg, 1, 3);
+  Adafruit_I2CRegisterBits modebit =
+      Adafruit_I2CRegisterBits(&ledmodereg, 1, 3);
+  confbit.write(0);
+  modebit.write(1);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(1);  // wait for serial port to open
+
+  if (! aw.begin(0x58)) {
+    Serial.println("AW9523 not found? Check wiring!");
+    while (1) delay(10);  // halt forever
+  }
+  haveSecond = aw2.begin(0x59);
+  legacyDev.begin();
+  // every begin() above runs Wire.begin(), which puts the clock back to
+  // the core's default, so set it after the last of them
+  Wire.setClock(BUS_HZ);
+  aw.setBusCost(BUS_HZ, 20);
+  aw.configureDirection(0x00FF);  // port 0 outputs, port 1 inputs
+
+  Serial.print("info,f_cpu,");
+  Serial.println(F_CPU);
+  Serial.print("info,bus_hz,");
+  Serial.println(BUS_HZ);
+  Serial.print("info,chips,");
+  Serial.println(haveSecond ? 2 : 1);
+
+  // per pin, the old way and the new way
+  bench("legacy_digitalWrite", legacyDigitalWrite);
+  bench("digitalWrite", [] { aw.digitalWrite(3, counter & 1); });
+  bench("legacy_digitalRead", legacyDigitalRead);
+  bench("digitalRead", [] { aw.digitalRead(9); });
+  bench("legacy_pinMode", legacyPinMode);
+  bench("pinMode", [] { aw.pinMode(3, OUTPUT); });
+  bench("analogWrite", [] { aw.analogWrite(3, counter); });
+  bench("enableInterrupt", [] { aw.enableInterrupt(9, counter & 1); });
+
+  // all 16 pins at once
+  bench("outputGPIO", [] { aw.outputGPIO(counter); });
+  bench("inputGPIO", [] { aw.inputGPIO(); });
+  bench("configureDirection", [] { aw.configureDirection(0x00FF); });
+  bench("interruptEnableGPIO", [] { aw.interruptEnableGPIO(counter); });
+  bench("analogWriteGPIO", [] {
+    static uint8_t levels[16];
+    levels[counter & 0xF] = counter;
+    aw.analogWriteGPIO(levels);
+  });
+
+  // cached, no reads
+  bench("outputGPIOMasked_1port", [] { aw.outputGPIOMasked(counter, 0x00FF); });
+  bench("outputGPIOMasked_2port", [] {
+    aw.outputGPIOMasked(counter * 0x0101, 0xFFFF);
+  });
+  bench("outputPort", [] { aw.outputPort(0, counter); });
+  bench("outputs_cached", [] { aw.outputs(); });
+
+  // typed register access
+  bench("writeField_whole", [] { aw.writeField<AW9523_DIM<3>>(counter); });
+  bench("writeField_bits", [] { aw.writeField<AW9523_GCR_ISEL>(counter & 3); });
+  bench("readField", [] {
+    uint8_t id;
+    aw.readField<AW9523_CHIPID>(&id);
+  });
+  bench("readRegister16", [] {
+    uint16_t v;
+    aw.readRegister16<AW9523_INPUT>(&v);
+  });
+
+  // input servicing, one port of interest or both
+  aw.setInterest(0x0200);
+  bench("service_1port", [] {
+    aw.interruptTriggered();
+    aw.service();
+  });
+  Serial.print("info,service_1port_est_us,");
+  Serial.println(aw.serviceMicros());
+  aw.setInterest(0x0201);
+  bench("service_2port", [] {
+    aw.interruptTriggered();
+    aw.service();
+  });
+  Serial.print("info,service_2port_est_us,");
+  Serial.println(aw.serviceMicros());
+  aw.setInterest(0);
+
+  // verify after write
+  aw.setVerifyWrites(true);
+  bench("outputGPIO_verified", [] { aw.outputGPIO(counter); });
+  aw.setVerifyWrites(false);
+
+  // background work, with nothing due and with an edge to service
+  bench("update_idle", [] { aw.update(1000); });
+  bench("update_service", [] {
+    aw.interruptTriggered();
+    aw.update(1000);
+  });
+
+  // set-up calls, reset() last as it undoes the rest
+  bench("configureLEDMode", [] { aw.configureLEDMode(0x0000); });
+  bench("openDrainPort0", [] { aw.openDrainPort0(false); });
+  bench("reset", [] { aw.reset(); });
+  aw.configureDirection(0x00FF);
+  aw.interruptEnableGPIO(0);
+
+  // helpers built on the driver, all on port 0
+  cs.begin(0x00F0);
+  bench("chipSelect_select_deselect", [] {
+    cs.select(4 + (counter & 3));
+    cs.deselect();
+  });
+  mux.begin(0, 3, MUX_ANALOG);
+  bench("mux_select", [] { mux.select(counter & 7); });
+  bench("mux_scan", [] {
+    uint16_t values[8];
+    mux.scan(values);
+  });
+  blinker.begin(1);
+  for (uint8_t pin = 0; pin < 8; pin++) {
+    blinker.blink(pin, 2 + pin); // every 1ms tick changes some pin
+  }
+  benchDue("blinker_run", [] { blinker.run(); });
+  for (uint8_t pin = 0; pin < 8; pin++) {
+    blinker.stop(pin);
+  }
+  steppers.attach(0, 0, AW9523_STEP_HALF);
+  steppers.attach(1, 4, AW9523_STEP_HALF);
+  for (uint8_t motor = 0; motor < 2; motor++) {
+    steppers.setSpeed(motor, 1000, 0);
+    steppers.moveTo(motor, 100000);
+  }
+  benchDue("steppers_run", [] { steppers.run(); });
+  steppers.release(0);
+  steppers.release(1);
+
+#ifdef SOFT_SDA
+  // the same chip through bit-banged I2C, at the bus clock and flat out
+  softBus.begin(SOFT_SDA, SOFT_SCL, BUS_HZ);
+  if (softAw.begin(0x58, &softBus)) {
+    softAw.configureDirection(0x00FF);
+    bench("soft_outputGPIO", [] { softAw.outputGPIO(counter); });
+    bench("soft_inputGPIO", [] { softAw.inputGPIO(); });
+    softBus.setClock(0);
+    bench("soft_outputGPIO_flatout", [] { softAw.outputGPIO(counter); });
+    bench("soft_inputGPIO_flatout", [] { softAw.inputGPIO(); });
+  } else {
+    Serial.println("info,soft_i2c,not found");
+  }
+#endif
+
+  // several chips, chained with repeated starts or not
+  if (haveSecond) {
+    group.add(&aw);
+    group.add(&aw2);
+
+    // start-up, one chip after another or a stage at a time. Both run
+    // Wire.begin() first, so both run at the core's default clock
+    uint32_t start = micros();
+    aw.begin(0x58);
+    aw2.begin(0x59);
+    Serial.print("info,serial_init_us,");
+    Serial.println(micros() - start);
+    const uint8_t addresses[2] = {0x58, 0x59};
+    group.begin(addresses);
+    Serial.print("info,group_init_us,");
+    Serial.println(group.lastInitMicros());
+    for (uint8_t i = 0; i < 2; i++) {
+      Serial.print("info,group_init_chip");
+      Serial.print(i);
+      Serial.print("_us,");
+      Serial.println(group.initMicros(i));
+    }
+    Wire.setClock(BUS_HZ); // undo the begin()s
+    aw.configureDirection(0x00FF);
+    aw2.configureDirection(0xFFFF);
+
+    group.setChained(false);
+    bench("group_flush_unchained", [] {
+      group.stageOutputs(0, counter);
+      group.stageOutputs(1, ~counter);
+      group.flush();
+    });
+    group.setChained(true);
+    bench("group_flush_chained", [] {
+      group.stageOutputs(0, counter);
+      group.stageOutputs(1, ~counter);
+      group.flush();
+    });
+    bench("group_writeSynchronized", [] {
+      uint16_t words[2] = {counter, (uint16_t)~counter};
+      group.writeSynchronized(words);
+    });
+    Serial.print("info,last_skew_us,");
+    Serial.println(group.lastSkewMicros());
+    bench("group_readInputs", [] { group.readInputs(); });
+  }
+
+  // no bus traffic, but far too slow for the CPU only loop below
+  bench("printMetrics", [] {
+    Adafruit_AW9523::printMetrics(nullPrint, chips, haveSecond ? 2 : 1);
+  });
+
+#ifdef AW9523_FAULT_INJECTION
+  // from no faults up to one transfer in ten
+  const uint16_t faultRates[] = {0, 66, 655, 3277, 6554};
+  for (uint8_t i = 0; i < sizeof(faultRates) / sizeof(faultRates[0]); i++) {
+    faultSweep(faultRates[i]);
+  }
+  aw9523_fault_rates_t none = {0, 0, 0, 0, 0, 0, 0, 0};
+  aw.setFaultRates(none);
+  aw.configureDirection(0x00FF); // in case an injected reset undid it
+#endif
+
+  // CPU work only, no bus traffic in any of these
+  cpuEmptyNanos = cpuNanos([] {});
+  Serial.print("info,cpu_loop_ns,");
+  Serial.println(cpuEmptyNanos);
+  cpu("dimRegister", [] {
+    volatile uint8_t reg = AW9523_dimRegister(counter & 0xF);
+    (void)reg;
+  });
+  for (uint16_t i = 0; i < AW9523_GROUP_MAX; i++) {
+    cpuGroup.add(&aw);
+  }
+  cpu("group_stageOutputs", [] {
+    cpuGroup.stageOutputs(counter % AW9523_GROUP_MAX, counter);
+  });
+  cpu("group_changedInputs", [] { cpuGroup.changedInputs(changedList); });
+  cpu("group_changedChips", [] {
+    shadowA[counter % sizeof(shadowA)] ^= 1;
+    Adafruit_AW9523_Group::changedChips(shadowA, shadowB, AW9523_GROUP_MAX, 2,
+                                        changedList);
+  });
+  buttons.begin(0xFF00);
+  cpu("buttons_tick", [] { buttons.tick(counter << 8); });
+  cpu("buttons_tick_read", [] {
+    aw9523_button_event_t event;
+    buttons.tick(counter << 8);
+    while (buttons.read(&event)) {
+    }
+  });
+  frame.begin(0x0001);
+  cpu("ledframe_setPixel_show", [] {
+    frame.setPixel(counter & 0xF, counter);
+    frame.show();
+  });
+
+  Serial.println("done");
+}
+
+
+void loop() {
+  delay(1000);
+}
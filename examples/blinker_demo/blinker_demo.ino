@@ -0,0 +1,37 @@
+// Eight LEDs on pins 0-7, each blinking at its own rate. Toggles that fall
+// on the same tick go out in one I2C write.
+#include <Adafruit_AW9523.h>
+#include <Adafruit_AW9523_Blinker.h>
+
+Adafruit_AW9523 aw;
+Adafruit_AW9523_Blinker blinker(&aw);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(1);  // wait for serial port to open
+  
+  Serial.println("Adafruit AW9523 multi-pin blink test!");
+
+  if (! aw.begin(0x58)) {
+    Serial.println("AW9523 not found? Check wiring!");
+    while (1) delay(10);  // halt forever
+  }
+
+  Serial.println("AW9523 found!");
+  blinker.begin(10);  // 10ms ticks
+  for (uint8_t pin = 0; pin < 8; pin++) {
+    blinker.blink(pin, 200 * (pin + 1), 50);  // 200ms, 400ms, ... periods
+  }
+}
+
+
+void loop() {
+  blinker.run();
+
+  static uint32_t lastPrint = 0;
+  if (millis() - lastPrint > 1000) {
+    lastPrint = millis();
+    Serial.print(blinker.writesPerSecond());
+    Serial.println(" writes/s");
+  }
+}
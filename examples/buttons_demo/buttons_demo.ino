@@ -0,0 +1,39 @@
+// Buttons from expander pins 8-15 to ground. Prints presses, clicks,
+// double clicks, long presses and repeats.
+#include <Adafruit_AW9523.h>
+#include <Adafruit_AW9523_Buttons.h>
+
+Adafruit_AW9523 aw;
+Adafruit_AW9523_Buttons buttons(&aw);
+
+const char *const eventNames[] = {"press", "release", "click",
+                                  "double click", "long press", "repeat"};
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(1);  // wait for serial port to open
+  
+  Serial.println("Adafruit AW9523 buttons test!");
+
+  if (! aw.begin(0x58)) {
+    Serial.println("AW9523 not found? Check wiring!");
+    while (1) delay(10);  // halt forever
+  }
+
+  Serial.println("AW9523 found!");
+  // the AW9523 has no pullups, add external ones to each button pin
+  buttons.begin(0xFF00, true, 10);  // active low, 10ms ticks
+}
+
+
+void loop() {
+  buttons.poll();
+
+  aw9523_button_event_t event;
+  while (buttons.read(&event)) {
+    Serial.print("Button ");
+    Serial.print(event.pin);
+    Serial.print(": ");
+    Serial.println(eventNames[event.type]);
+  }
+}
@@ -0,0 +1,427 @@
+// Checks on real hardware that the driver's fast paths (output shadow,
+// bursts, masked writes, group staging and flushes) leave the chips in the
+// same state as doing the same job the way the library used to, one
+// Adafruit_I2CRegisterBits read-modify-write per call.
+//
+// Needs two chips on the bus, at 0x58 and 0x59. Each round makes a random
+// list of operations from a seed, runs it once the legacy way and once
+// through the driver, each from a soft reset, and compares the register
+// files read back from both chips. One line per round:
+//
+//   round,<n>,<seed>,<ops>,ok
+//   round,<n>,<seed>,<ops>,FAIL,<chip>.<reg>=<legacy>/<driver>,...
+//
+// then the operations of a failing round, so it can be replayed by seed.
+// The dimming registers are write only and are not compared.
+//
+// Built with AW9523_FAULT_INJECTION, rounds that verify writes also flip a
+// bit in a synchronized write to one chip and check the next flush puts
+// the right word back.
+//
+// Leave the GPIO pins unconnected: the test drives them at random.
+#include <Adafruit_AW9523.h>
+#include <Adafruit_AW9523_Group.h>
+
+#define ROUNDS 200 // rounds to run
+#define OPS 24     // operations per round
+
+Adafruit_AW9523 aw0;
+Adafruit_AW9523 aw1;
+Adafruit_AW9523 *const chips[2] = {&aw0, &aw1};
+Adafruit_AW9523_Group group;
+Adafruit_I2CDevice legacyDev0(0x58);
+Adafruit_I2CDevice legacyDev1(0x59);
+Adafruit_I2CDevice *const legacyDevs[2] = {&legacyDev0, &legacyDev1};
+
+// Registers compared, as read by snapshot(): 0x02-0x07 then 0x11-0x13
+const char *const checkNames[] = {
+    "OUTPUT0",    "OUTPUT1", "CONFIG0",  "CONFIG1", "INTENABLE0",
+    "INTENABLE1", "GCR",     "LEDMODE0", "LEDMODE1"};
+#define CHECK_REGS 9
+
+enum {
+  OP_DIGITALWRITE,
+  OP_PINMODE,
+  OP_ENABLEINTERRUPT,
+  OP_OUTPUTGPIO,
+  OP_OUTPUTMASKED,
+  OP_OUTPUTPORT,
+  OP_DIRECTION,
+  OP_INTENABLE,
+  OP_LEDMODE,
+  OP_OPENDRAIN,
+  OP_ISEL,
+  OP_GROUPSTAGE,
+  OP_GROUPFLUSH,
+  OP_SYNCHRONIZED,
+#ifdef AW9523_FAULT_INJECTION
+  OP_CORRUPTSYNC,
+#endif
+  OP_KINDS
+};
+
+const char *const opNames[] = {"digitalWrite",
+                               "pinMode",
+                               "enableInterrupt",
+                               "outputGPIO",
+                               "outputGPIOMasked",
+                               "outputPort",
+                               "configureDirection",
+                               "interruptEnableGPIO",
+                               "configureLEDMode",
+                               "openDrainPort0",
+                               "writeField<ISEL>",
+                               "group_stageOutputs",
+                               "group_stageOutputs_flush",
+                               "group_writeSynchronized",
+#ifdef AW9523_FAULT_INJECTION
+                               "group_writeSynchronized_corrupt",
+#endif
+};
+
+// One operation. For the group ones chip is a mask of the chips to stage,
+// and a and b are the words for chips 0 and 1
+typedef struct {
+  uint8_t kind;
+  uint8_t chip;
+  uint16_t a;
+  uint16_t b;
+} op_t;
+
+// Words staged on the legacy side, written at the next flush
+uint16_t pending[2];
+uint8_t pendingMask = 0;
+
+// True while the driver side reads back its writes
+bool verifying = false;
+
+uint32_t failures = 0;
+
+// Half of the words come from a few common values, so that writes of the
+// value a shadow already holds, the ones a cache may skip, happen often
+uint16_t randomWord() {
+  static const uint16_t common[] = {0x0000, 0xFFFF, 0x00FF, 0xFF00};
+  return random(2) ? random(0x10000) : common[random(4)];
+}
+
+op_t nextOp() {
+  op_t op;
+  op.kind = random(OP_KINDS);
+  op.chip = random(2);
+  switch (op.kind) {
+  case OP_DIGITALWRITE:
+  case OP_ENABLEINTERRUPT:
+    op.a = random(16);
+    op.b = random(2);
+    break;
+  case OP_PINMODE:
+    op.a = random(16);
+    op.b = random(3); // INPUT, OUTPUT, AW9523_LED_MODE
+    break;
+  case OP_OUTPUTPORT:
+    op.a = random(2);
+    op.b = random(256);
+    break;
+  case OP_OPENDRAIN:
+    op.a = random(2);
+    break;
+  case OP_ISEL:
+    op.a = random(4);
+    break;
+  case OP_GROUPSTAGE:
+  case OP_GROUPFLUSH:
+    op.chip = 1 + random(3); // either chip or both
+    op.a = randomWord();
+    op.b = randomWord();
+    break;
+  default:
+    op.a = randomWord();
+    op.b = randomWord();
+  }
+  return op;
+}
+
+uint8_t pinModeOf(uint16_t choice) {
+  return (choice == 0) ? INPUT : (choice == 1) ? OUTPUT : AW9523_LED_MODE;
+}
+
+void legacyWrite(uint8_t chip, uint8_t reg, uint16_t value) {
+  Adafruit_I2CRegister r(legacyDevs[chip], reg, 2, LSBFIRST);
+  r.write(value);
+}
+
+// One read-modify-write per bit in mask, as the library used to
+void legacyBits(uint8_t chip, uint8_t reg, uint8_t width, uint16_t bits,
+                uint16_t mask) {
+  Adafruit_I2CRegister r(legacyDevs[chip], reg, width, LSBFIRST);
+  for (uint8_t bit = 0; bit < width * 8; bit++) {
+    if (mask & (1U << bit)) {
+      Adafruit_I2CRegisterBits(&r, 1, bit).write((bits >> bit) & 1);
+    }
+  }
+}
+
+void legacyFlush() {
+  for (uint8_t c = 0; c < 2; c++) {
+    if (pendingMask & (1 << c)) {
+      legacyWrite(c, AW9523_REG_OUTPUT0, pending[c]);
+    }
+  }
+  pendingMask = 0;
+}
+
+void legacyOp(const op_t &op) {
+  uint8_t c = op.chip;
+  uint8_t mode;
+  switch (op.kind) {
+  case OP_DIGITALWRITE:
+    legacyBits(c, AW9523_REG_OUTPUT0, 2, op.b << op.a, 1U << op.a);
+    break;
+  case OP_PINMODE:
+    mode = pinModeOf(op.b);
+    legacyBits(c, AW9523_REG_CONFIG0, 2, (mode == INPUT) << op.a, 1U << op.a);
+    legacyBits(c, AW9523_REG_LEDMODE0, 2, (mode != AW9523_LED_MODE) << op.a,
+               1U << op.a);
+    break;
+  case OP_ENABLEINTERRUPT:
+    legacyBits(c, AW9523_REG_INTENABLE0, 2, !op.b << op.a, 1U << op.a);
+    break;
+  case OP_OUTPUTGPIO:
+    legacyWrite(c, AW9523_REG_OUTPUT0, op.a);
+    break;
+  case OP_OUTPUTMASKED:
+    legacyBits(c, AW9523_REG_OUTPUT0, 2, op.a, op.b);
+    break;
+  case OP_OUTPUTPORT:
+    legacyBits(c, AW9523_REG_OUTPUT0, 2, op.b << (op.a * 8),
+               0xFF << (op.a * 8));
+    break;
+  case OP_DIRECTION:
+    legacyWrite(c, AW9523_REG_CONFIG0, ~op.a);
+    break;
+  case OP_INTENABLE:
+    legacyWrite(c, AW9523_REG_INTENABLE0, ~op.a);
+    break;
+  case OP_LEDMODE:
+    legacyWrite(c, AW9523_REG_LEDMODE0, ~op.a);
+    break;
+  case OP_OPENDRAIN:
+    legacyBits(c, AW9523_REG_GCR, 1, !op.a << 4, 0x10);
+    break;
+  case OP_ISEL:
+    legacyBits(c, AW9523_REG_GCR, 1, op.a, 0x03);
+    break;
+  case OP_GROUPSTAGE:
+  case OP_GROUPFLUSH:
+    if (c & 1) {
+      pending[0] = op.a;
+    }
+    if (c & 2) {
+      pending[1] = op.b;
+    }
+    pendingMask |= c;
+    if (op.kind == OP_GROUPFLUSH) {
+      legacyFlush();
+    }
+    break;
+  case OP_SYNCHRONIZED:
+#ifdef AW9523_FAULT_INJECTION
+  case OP_CORRUPTSYNC:
+#endif
+    pending[0] = op.a;
+    pending[1] = op.b;
+    pendingMask = 3;
+    legacyFlush();
+    break;
+  }
+}
+
+void driverOp(const op_t &op) {
+  Adafruit_AW9523 *aw = chips[op.chip & 1];
+  uint16_t words[2] = {op.a, op.b};
+  switch (op.kind) {
+  case OP_DIGITALWRITE:
+    aw->digitalWrite(op.a, op.b);
+    break;
+  case OP_PINMODE:
+    aw->pinMode(op.a, pinModeOf(op.b));
+    break;
+  case OP_ENABLEINTERRUPT:
+    aw->enableInterrupt(op.a, op.b);
+    break;
+  case OP_OUTPUTGPIO:
+    aw->outputGPIO(op.a);
+    break;
+  case OP_OUTPUTMASKED:
+    aw->outputGPIOMasked(op.a, op.b);
+    break;
+  case OP_OUTPUTPORT:
+    aw->outputPort(op.a, op.b);
+    break;
+  case OP_DIRECTION:
+    aw->configureDirection(op.a);
+    break;
+  case OP_INTENABLE:
+    aw->interruptEnableGPIO(op.a);
+    break;
+  case OP_LEDMODE:
+    aw->configureLEDMode(op.a);
+    break;
+  case OP_OPENDRAIN:
+    aw->openDrainPort0(op.a);
+    break;
+  case OP_ISEL:
+    aw->writeField<AW9523_GCR_ISEL>(op.a);
+    break;
+  case OP_GROUPSTAGE:
+  case OP_GROUPFLUSH:
+    for (uint8_t c = 0; c < 2; c++) {
+      if (op.chip & (1 << c)) {
+        group.stageOutputs(c, words[c]);
+      }
+    }
+    if (op.kind == OP_GROUPFLUSH) {
+      group.flush();
+    }
+    break;
+  case OP_SYNCHRONIZED:
+    group.writeSynchronized(words);
+    break;
+#ifdef AW9523_FAULT_INJECTION
+  case OP_CORRUPTSYNC:
+    if (verifying) {
+      // the chip latches a flipped bit, the read back catches it and the
+      // flush writes the word again
+      aw9523_fault_rates_t corrupt = {0, 0, 0, 0, 0, 0, 0, 65535};
+      aw9523_fault_rates_t none = {0, 0, 0, 0, 0, 0, 0, 0};
+      aw->setFaultRates(corrupt);
+      group.writeSynchronized(words);
+      aw->setFaultRates(none);
+      group.flush();
+    } else {
+      group.writeSynchronized(words);
+    }
+    break;
+#endif
+  }
+}
+
+bool snapshot(uint8_t regs[2][CHECK_REGS]) {
+  for (uint8_t c = 0; c < 2; c++) {
+    uint8_t reg = AW9523_REG_OUTPUT0;
+    if (!legacyDevs[c]->write_then_read(&reg, 1, regs[c], 6)) {
+      return false;
+    }
+    reg = AW9523_REG_GCR;
+    if (!legacyDevs[c]->write_then_read(&reg, 1, regs[c] + 6, 3)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void printOps(uint32_t seed) {
+  randomSeed(seed);
+  for (uint8_t i = 0; i < OPS; i++) {
+    op_t op = nextOp();
+    Serial.print("  ");
+    Serial.print(opNames[op.kind]);
+    Serial.print("(chip ");
+    Serial.print(op.chip);
+    Serial.print(", 0x");
+    Serial.print(op.a, HEX);
+    Serial.print(", 0x");
+    Serial.print(op.b, HEX);
+    Serial.println(")");
+  }
+}
+
+void runRound(uint32_t n, uint32_t seed) {
+  uint8_t legacyRegs[2][CHECK_REGS], driverRegs[2][CHECK_REGS];
+  uint8_t zero = 0;
+  bool ok = true;
+
+  for (uint8_t c = 0; c < 2; c++) {
+    Adafruit_I2CRegister(legacyDevs[c], AW9523_REG_SOFTRESET).write(zero);
+  }
+  pendingMask = 0;
+  randomSeed(seed);
+  for (uint8_t i = 0; i < OPS; i++) {
+    legacyOp(nextOp());
+  }
+  ok &= snapshot(legacyRegs);
+
+  verifying = n & 1;
+  for (uint8_t c = 0; c < 2; c++) {
+    // alternate rounds read back every driver write as well
+    chips[c]->setVerifyWrites(verifying);
+    ok &= chips[c]->reset();
+  }
+  randomSeed(seed);
+  for (uint8_t i = 0; i < OPS; i++) {
+    driverOp(nextOp());
+  }
+  ok &= snapshot(driverRegs);
+  group.flush(); // nothing left staged for the next round
+
+  Serial.print("round,");
+  Serial.print(n);
+  Serial.print(",");
+  Serial.print(seed);
+  Serial.print(",");
+  Serial.print(OPS);
+  if (!ok) {
+    failures++;
+    Serial.println(",FAIL,bus error");
+    return;
+  }
+  if (!memcmp(legacyRegs, driverRegs, sizeof(legacyRegs))) {
+    Serial.println(",ok");
+    return;
+  }
+
+  failures++;
+  Serial.print(",FAIL");
+  for (uint8_t c = 0; c < 2; c++) {
+    for (uint8_t r = 0; r < CHECK_REGS; r++) {
+      if (legacyRegs[c][r] != driverRegs[c][r]) {
+        Serial.print(",");
+        Serial.print(c);
+        Serial.print(".");
+        Serial.print(checkNames[r]);
+        Serial.print("=0x");
+        Serial.print(legacyRegs[c][r], HEX);
+        Serial.print("/0x");
+        Serial.print(driverRegs[c][r], HEX);
+      }
+    }
+  }
+  Serial.println();
+  printOps(seed);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(1);  // wait for serial port to open
+
+  if (! aw0.begin(0x58) || ! aw1.begin(0x59)) {
+    Serial.println("AW9523s not found at 0x58 and 0x59? Check wiring!");
+    while (1) delay(10);  // halt forever
+  }
+  legacyDev0.begin();
+  legacyDev1.begin();
+  group.add(&aw0);
+  group.add(&aw1);
+
+  Serial.println("# leave the GPIO pins unconnected");
+  for (uint32_t n = 0; n < ROUNDS; n++) {
+    runRound(n, 1000 + n);
+  }
+  Serial.print("done,");
+  Serial.print(ROUNDS);
+  Serial.print(",");
+  Serial.println(failures);
+}
+
+void loop() {
+}
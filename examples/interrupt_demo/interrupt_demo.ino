@@ -0,0 +1,52 @@
+// Wire the AW9523 INT pin to IntPin on the host. Build the library with
+// AW9523_LATENCY_STATS defined to also get the latency distributions.
+#include <Adafruit_AW9523.h>
+
+Adafruit_AW9523 aw;
+
+uint8_t ButtonPin = 1;  // 0 thru 15
+uint8_t IntPin = 2;     // host pin with interrupt support
+
+void awInterrupt() {
+  aw.interruptTriggered();
+}
+
+void buttonChanged(uint16_t changed, uint16_t inputs) {
+  Serial.print("Changed: 0x");
+  Serial.print(changed, HEX);
+  Serial.print(" inputs: 0x");
+  Serial.println(inputs, HEX);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(1);  // wait for serial port to open
+  
+  Serial.println("Adafruit AW9523 interrupt test!");
+
+  if (! aw.begin(0x58)) {
+    Serial.println("AW9523 not found? Check wiring!");
+    while (1) delay(10);  // halt forever
+  }
+
+  Serial.println("AW9523 found!");
+  aw.pinMode(ButtonPin, INPUT);
+  aw.enableInterrupt(ButtonPin, true);
+  aw.onChange(buttonChanged);
+
+  pinMode(IntPin, INPUT_PULLUP);  // INT is open drain, active low
+  attachInterrupt(digitalPinToInterrupt(IntPin), awInterrupt, FALLING);
+}
+
+
+void loop() {
+  aw.service();
+
+#ifdef AW9523_LATENCY_STATS
+  static uint32_t lastPrint = 0;
+  if (millis() - lastPrint > 5000) {
+    lastPrint = millis();
+    aw.printLatencyStats(Serial);
+  }
+#endif
+}
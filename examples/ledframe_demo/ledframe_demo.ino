@@ -0,0 +1,43 @@
+// A chasing pattern on 16 constant current LEDs. The frame rate drops
+// by itself if the I2C bus gets too busy to keep up. Other traffic to the
+// AW9523 is counted for you; pass the time transfers to other devices on
+// the same bus take to leds.reportBusTime() to count those too.
+#include <Adafruit_AW9523.h>
+#include <Adafruit_AW9523_LEDFrame.h>
+
+Adafruit_AW9523 aw;
+Adafruit_AW9523_LEDFrame leds(&aw);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(1);  // wait for serial port to open
+  
+  Serial.println("Adafruit AW9523 LED frame test!");
+
+  if (! aw.begin(0x58)) {
+    Serial.println("AW9523 not found? Check wiring!");
+    while (1) delay(10);  // halt forever
+  }
+
+  Serial.println("AW9523 found!");
+  leds.begin(0xFFFF, 100, 50);  // all pins, 100 FPS, at most half the bus
+}
+
+
+void loop() {
+  uint8_t head = (millis() / 50) % 16;
+  for (uint8_t pin = 0; pin < 16; pin++) {
+    uint8_t distance = (head - pin) & 0xF;
+    leds.setPixel(pin, distance < 4 ? 255 >> (distance * 2) : 0);
+  }
+  leds.show();
+  leds.run();
+
+  static uint32_t lastPrint = 0;
+  if (millis() - lastPrint > 1000) {
+    lastPrint = millis();
+    Serial.print(leds.fps());
+    Serial.print(" FPS, dropped ");
+    Serial.println(leds.droppedFrames());
+  }
+}
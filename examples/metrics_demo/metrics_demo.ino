@@ -0,0 +1,45 @@
+// Prints the driver statistics in OpenMetrics text format every 10
+// seconds, one exposition ending in "# EOF" each time. On a Linux host a
+// small script can copy each exposition from the serial port to a file
+// for a node exporter's textfile collector, or serve it to a scraper.
+#include <Adafruit_AW9523.h>
+#include <Adafruit_AW9523_LEDFrame.h>
+
+Adafruit_AW9523 aw;
+Adafruit_AW9523_LEDFrame frame(&aw);
+
+Adafruit_AW9523 *chips[] = {&aw};
+Adafruit_AW9523_LEDFrame *frames[] = {&frame};
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(1);  // wait for serial port to open
+
+  if (! aw.begin(0x58)) {
+    Serial.println("AW9523 not found? Check wiring!");
+    while (1) delay(10);  // halt forever
+  }
+
+  aw.setHealthCheckInterval(1000);
+  frame.begin(0x00FF, 60);
+  aw.addTask(&frame);
+}
+
+
+void loop() {
+  // something to count: a light chasing along port 0
+  uint8_t pin = (millis() / 50) % 8;
+  for (uint8_t i = 0; i < 8; i++) {
+    frame.setPixel(i, (i == pin) ? 255 : 0);
+  }
+  frame.show();
+  aw.update(1000);
+
+  static uint32_t lastPrint = 0;
+  if (millis() - lastPrint > 10000) {
+    lastPrint = millis();
+    Adafruit_AW9523::printMetrics(Serial, chips, 1);
+    Adafruit_AW9523_LEDFrame::printMetrics(Serial, frames, 1);
+    Serial.println("# EOF");
+  }
+}
@@ -0,0 +1,38 @@
+// A 74HC4067 16 channel analog mux with S0-S3 on expander pins 0-3 and
+// the mux SIG pin on host pin A0.
+#include <Adafruit_AW9523.h>
+#include <Adafruit_AW9523_Mux.h>
+
+Adafruit_AW9523 aw;
+Adafruit_AW9523_Mux mux(&aw);
+
+uint16_t readings[16];
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(1);  // wait for serial port to open
+  
+  Serial.println("Adafruit AW9523 analog mux test!");
+
+  if (! aw.begin(0x58)) {
+    Serial.println("AW9523 not found? Check wiring!");
+    while (1) delay(10);  // halt forever
+  }
+
+  Serial.println("AW9523 found!");
+  mux.begin(0, 4, A0);
+}
+
+
+void loop() {
+  mux.scan(readings);
+
+  for (uint8_t ch = 0; ch < mux.channels(); ch++) {
+    Serial.print(readings[ch]);
+    Serial.print('\t');
+  }
+  Serial.print(mux.lastScanMicros());
+  Serial.println("us");
+
+  delay(100);
+}
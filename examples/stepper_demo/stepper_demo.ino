@@ -0,0 +1,35 @@
+// Two unipolar steppers (e.g. 28BYJ-48 through a ULN2003) on pins 0-3 and
+// 4-7. Both motors' coils are updated with one I2C write per tick.
+#include <Adafruit_AW9523.h>
+#include <Adafruit_AW9523_Steppers.h>
+
+Adafruit_AW9523 aw;
+Adafruit_AW9523_Steppers steppers(&aw);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(1);  // wait for serial port to open
+  
+  Serial.println("Adafruit AW9523 Stepper test!");
+
+  if (! aw.begin(0x58)) {
+    Serial.println("AW9523 not found? Check wiring!");
+    while (1) delay(10);  // halt forever
+  }
+
+  Serial.println("AW9523 found!");
+  steppers.attach(0, 0, AW9523_STEP_HALF);
+  steppers.attach(1, 4, AW9523_STEP_FULL);
+  steppers.setSpeed(0, 800, 400);  // steps/s, steps/s/s
+  steppers.setSpeed(1, 400, 200);
+}
+
+
+void loop() {
+  if (!steppers.running(0) && !steppers.running(1)) {
+    // back and forth, one turn of a 28BYJ-48 is 4096 half steps
+    steppers.moveTo(0, steppers.position(0) ? 0 : 4096);
+    steppers.moveTo(1, steppers.position(1) ? 0 : -2048);
+  }
+  steppers.run();
+}
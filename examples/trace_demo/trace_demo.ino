@@ -0,0 +1,49 @@
+// Records a timeline of the library's work and prints it as Chrome
+// trace-event JSON, one event per line. Build the library with
+// AW9523_TRACE defined, copy everything from {"traceEvents" down to the
+// line that ends with "dropped":<n>}} into a .json file and open it at
+// ui.perfetto.dev or chrome://tracing.
+#include <Adafruit_AW9523.h>
+#include <Adafruit_AW9523_LEDFrame.h>
+#include <Adafruit_AW9523_Trace.h>
+
+Adafruit_AW9523 aw;
+Adafruit_AW9523_LEDFrame frame(&aw);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(1);  // wait for serial port to open
+
+#ifndef AW9523_TRACE
+  Serial.println("Build the library with AW9523_TRACE defined!");
+  while (1) delay(10);  // halt forever
+#endif
+
+  if (! aw.begin(0x58)) {
+    Serial.println("AW9523 not found? Check wiring!");
+    while (1) delay(10);  // halt forever
+  }
+
+  frame.begin(0x00FF, 60);
+  aw.addTask(&frame);
+  aw.setPollInterval(20);
+  aw.setHealthCheckInterval(250);
+}
+
+
+void loop() {
+  uint8_t pin = (millis() / 50) % 8;
+  for (uint8_t i = 0; i < 8; i++) {
+    frame.setPixel(i, (i == pin) ? 255 : 0);
+  }
+  frame.show();
+  aw.update(1000);
+
+#ifdef AW9523_TRACE
+  static uint32_t lastPrint = 0;
+  if (millis() - lastPrint > 1000) {
+    lastPrint = millis();
+    Adafruit_AW9523_Trace::printJSON(Serial);
+  }
+#endif
+}
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Flash and RAM footprint of the library, per feature configuration.
+
+Compiles footprint_sketch in each configuration for each board with
+arduino-cli, reads text/data/bss from the ELF with the board's own size
+tool, and compares them with baseline.json next to this script.
+
+    python3 extras/footprint/footprint.py            # report, fail on growth
+    python3 extras/footprint/footprint.py --update   # save a new baseline
+
+Needs arduino-cli on the PATH with the arduino:avr and arduino:samd cores
+and the Adafruit BusIO library installed. There is no baseline until the
+first run with --update on a known good tree.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+LIBRARY = os.path.dirname(os.path.dirname(HERE))
+SKETCH = os.path.join(HERE, "footprint_sketch")
+BASELINE = os.path.join(HERE, "baseline.json")
+
+BOARDS = {
+    "avr": "arduino:avr:uno",
+    "arm": "arduino:samd:arduino_zero_native",
+}
+
+CONFIGS = {
+    "minimal": "-DAW9523_FOOTPRINT_CONFIG=1",
+    "cached": "-DAW9523_FOOTPRINT_CONFIG=2",
+    "batched": "-DAW9523_FOOTPRINT_CONFIG=3",
+    "full": "-DAW9523_FOOTPRINT_CONFIG=4 -DAW9523_LATENCY_STATS "
+    "-DAW9523_TRACE",
+    "faults": "-DAW9523_FOOTPRINT_CONFIG=2 -DAW9523_FAULT_INJECTION",
+}
+
+SECTIONS = ("text", "data", "bss")
+
+
+def size_tool(fqbn):
+    """Finds the size tool of a board's toolchain, e.g. avr-size."""
+    out = subprocess.run(
+        ["arduino-cli", "compile", "--show-properties", "-b", fqbn, SKETCH],
+        check=True, capture_output=True, text=True).stdout
+    props = dict(line.split("=", 1) for line in out.splitlines()
+                 if "=" in line)
+    return os.path.join(props["compiler.path"], props["compiler.size.cmd"])
+
+
+def measure(fqbn, flags, size):
+    """Compiles the sketch and returns its text/data/bss in bytes."""
+    with tempfile.TemporaryDirectory() as build:
+        subprocess.run(
+            ["arduino-cli", "compile", "-b", fqbn, "--library", LIBRARY,
+             "--build-path", build,
+             "--build-property", "compiler.cpp.extra_flags=" + flags,
+             "--build-property", "compiler.c.extra_flags=" + flags, SKETCH],
+            check=True, capture_output=True, text=True)
+        elf = os.path.join(build, "footprint_sketch.ino.elf")
+        out = subprocess.run([size, elf], check=True, capture_output=True,
+                             text=True).stdout
+    # Berkeley format: text data bss dec hex filename
+    values = re.split(r"\s+", out.strip().splitlines()[-1].strip())
+    return dict(zip(SECTIONS, (int(v) for v in values[:3])))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--update", action="store_true",
+                        help="save the results as the new baseline")
+    parser.add_argument("--tolerance", type=int, default=0,
+                        help="bytes a section may grow before failing")
+    args = parser.parse_args()
+
+    baseline = {}
+    if os.path.exists(BASELINE):
+        with open(BASELINE) as f:
+            baseline = json.load(f)
+
+    results = {}
+    grew = False
+    print("%-4s %-8s %14s %14s %14s" % (("arch", "config") + SECTIONS))
+    for arch, fqbn in BOARDS.items():
+        size = size_tool(fqbn)
+        for config, flags in CONFIGS.items():
+            key = arch + "/" + config
+            sizes = measure(fqbn, flags, size)
+            results[key] = sizes
+            cells = []
+            for section in SECTIONS:
+                cell = str(sizes[section])
+                if key in baseline:
+                    delta = sizes[section] - baseline[key][section]
+                    cell += " (%+d)" % delta if delta else ""
+                    grew |= delta > args.tolerance
+                cells.append(cell)
+            print("%-4s %-8s %14s %14s %14s" % tuple([arch, config] + cells))
+
+    if args.update:
+        with open(BASELINE, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("baseline saved to " + os.path.relpath(BASELINE, LIBRARY))
+    elif not baseline:
+        print("no baseline yet, run with --update on a known good tree")
+    elif grew:
+        print("footprint grew past the baseline")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,125 @@
+// Representative uses of the library for extras/footprint/footprint.py,
+// one per configuration, picked with AW9523_FOOTPRINT_CONFIG:
+//
+//   1 minimal  per pin calls only
+//   2 cached   whole port and masked writes, interest driven servicing
+//   3 batched  multi-chip group with staged flushes
+//   4 full     everything, with latency stats and tracing compiled in
+//
+// Any configuration built with AW9523_FAULT_INJECTION also injects faults,
+// which footprint.py measures as "faults" on top of the cached one.
+#include <Adafruit_AW9523.h>
+
+#ifndef AW9523_FOOTPRINT_CONFIG
+#define AW9523_FOOTPRINT_CONFIG 1
+#endif
+
+#if AW9523_FOOTPRINT_CONFIG >= 3
+#include <Adafruit_AW9523_Group.h>
+#endif
+#if AW9523_FOOTPRINT_CONFIG >= 4
+#include <Adafruit_AW9523_Blinker.h>
+#include <Adafruit_AW9523_Buttons.h>
+#include <Adafruit_AW9523_LEDFrame.h>
+#include <Adafruit_AW9523_Steppers.h>
+#include <Adafruit_AW9523_Trace.h>
+#endif
+
+Adafruit_AW9523 aw;
+#if AW9523_FOOTPRINT_CONFIG >= 3
+Adafruit_AW9523 aw2;
+Adafruit_AW9523_Group group;
+#endif
+#if AW9523_FOOTPRINT_CONFIG >= 4
+Adafruit_AW9523_Blinker blinker(&aw);
+Adafruit_AW9523_Buttons buttons(&aw);
+Adafruit_AW9523_LEDFrame frame(&aw2);
+Adafruit_AW9523_Steppers steppers(&aw2);
+Adafruit_AW9523 *chips[] = {&aw, &aw2};
+#endif
+
+void changed(uint16_t changed, uint16_t inputs) {
+  Serial.println(changed & inputs);
+}
+
+void setup() {
+  Serial.begin(115200);
+  aw.begin(0x58);
+  aw.pinMode(0, OUTPUT);
+  aw.pinMode(8, INPUT);
+
+#if AW9523_FOOTPRINT_CONFIG >= 2
+  aw.setInterest(0x0100);
+  aw.onChange(changed, 0x0100);
+  aw.setPollInterval(10);
+#endif
+
+#ifdef AW9523_FAULT_INJECTION
+  aw9523_fault_rates_t rates = {655, 66, 66, 6, 6, 200, 2000};
+  aw.setFaultRates(rates);
+#endif
+
+#if AW9523_FOOTPRINT_CONFIG >= 3
+  const uint8_t addresses[2] = {0x58, 0x59};
+  group.add(&aw);
+  group.add(&aw2);
+  group.begin(addresses);
+#endif
+
+#if AW9523_FOOTPRINT_CONFIG >= 4
+  blinker.begin();
+  blinker.blink(1, 500);
+  buttons.begin(0xF000);
+  frame.begin(0x00FF);
+  steppers.attach(0, 8, AW9523_STEP_HALF);
+  steppers.setSpeed(0, 200, 400);
+  steppers.moveTo(0, 1000);
+  aw.addTask(&blinker);
+  aw.addTask(&buttons);
+  aw2.addTask(&frame);
+  aw2.addTask(&steppers);
+#endif
+}
+
+void loop() {
+  static uint16_t n = 0;
+  n++;
+
+  aw.digitalWrite(0, n & 1);
+  Serial.println(aw.digitalRead(8));
+
+#if AW9523_FOOTPRINT_CONFIG >= 2
+  aw.outputGPIOMasked(n, 0x00FE);
+  aw.outputPort(0, n);
+  uint8_t levels[16] = {0};
+  levels[n & 0xF] = 255;
+  aw.analogWriteGPIO(levels);
+  aw.update(1000);
+#endif
+
+#ifdef AW9523_FAULT_INJECTION
+  Serial.println(aw.faultCounts().nack);
+#endif
+
+#if AW9523_FOOTPRINT_CONFIG >= 3
+  group.stageOutputs(0, n);
+  group.stageOutputs(1, ~n);
+  group.flush();
+  uint16_t words[2] = {n, (uint16_t)~n};
+  group.writeSynchronized(words);
+  group.readInputs();
+#endif
+
+#if AW9523_FOOTPRINT_CONFIG >= 4
+  aw9523_button_event_t event;
+  while (buttons.read(&event)) {
+    Serial.println(event.pin);
+  }
+  frame.setPixel(n & 7, n);
+  frame.show();
+  aw2.update(1000);
+  aw.printLatencyStats(Serial);
+  Adafruit_AW9523::printMetrics(Serial, chips, 2);
+  Adafruit_AW9523_Trace::printJSON(Serial);
+#endif
+}